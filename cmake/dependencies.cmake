@@ -4,6 +4,7 @@ find_package(CURL REQUIRED)
 find_package(Boost 1.74.0 COMPONENTS filesystem)
 find_package(google_cloud_cpp_texttospeech REQUIRED)
 find_package(google_cloud_cpp_speech REQUIRED)
+find_package(ALSA REQUIRED)
 
 include(ExternalProject)
 
@@ -72,6 +73,46 @@ EXTERNALPROJECT_ADD(
 include_directories(${source_dir}/include)
 link_directories(${build_dir}/build)
 
+set(source_dir "${CMAKE_BINARY_DIR}/libminimp3-src")
+set(build_dir "${CMAKE_BINARY_DIR}/libminimp3-build")
+
+EXTERNALPROJECT_ADD(
+  libminimp3
+  GIT_REPOSITORY    https://github.com/lieff/minimp3.git
+  GIT_TAG           master
+  PATCH_COMMAND     ""
+  PREFIX            libminimp3-workspace
+  SOURCE_DIR        ${source_dir}
+  BINARY_DIR        ${build_dir}
+  CONFIGURE_COMMAND ""
+  BUILD_COMMAND     ""
+  UPDATE_COMMAND    ""
+  INSTALL_COMMAND   ""
+  TEST_COMMAND      ""
+)
+
+include_directories(${source_dir})
+
+set(source_dir "${CMAKE_BINARY_DIR}/libdrflac-src")
+set(build_dir "${CMAKE_BINARY_DIR}/libdrflac-build")
+
+EXTERNALPROJECT_ADD(
+  libdrflac
+  GIT_REPOSITORY    https://github.com/mackron/dr_libs.git
+  GIT_TAG           master
+  PATCH_COMMAND     ""
+  PREFIX            libdrflac-workspace
+  SOURCE_DIR        ${source_dir}
+  BINARY_DIR        ${build_dir}
+  CONFIGURE_COMMAND ""
+  BUILD_COMMAND     ""
+  UPDATE_COMMAND    ""
+  INSTALL_COMMAND   ""
+  TEST_COMMAND      ""
+)
+
+include_directories(${source_dir})
+
 IF(NOT Boost_FOUND)
     set(source_dir "${CMAKE_BINARY_DIR}/libboost-src")
     set(build_dir "${CMAKE_BINARY_DIR}/libboost-build")
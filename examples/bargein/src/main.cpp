@@ -0,0 +1,98 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/tts/interfaces/googleapi.hpp"
+#include "speech/tts/interfaces/googlebasic.hpp"
+#include "speech/tts/interfaces/googlecloud.hpp"
+#include "speech/tts/sinks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static const tts::voice_t voice{tts::language::polish, tts::gender::female,
+                                1};
+
+template <typename T, typename C>
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(const tts::options_t& options,
+              std::shared_ptr<logs::LogIf> logif)
+{
+    return tts::TextToVoiceFactory::create<T, C>({voice, options, logif});
+}
+
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(const std::string& backend, const tts::options_t& options,
+              std::shared_ptr<logs::LogIf> logif)
+{
+    if (backend == "basic")
+        return createtts<tts::googlebasic::TextToVoice,
+                         tts::googlebasic::configext_t>(options, logif);
+    if (backend == "api")
+        return createtts<tts::googleapi::TextToVoice,
+                         tts::googleapi::configext_t>(options, logif);
+    if (backend == "cloud")
+        return createtts<tts::googlecloud::TextToVoice,
+                         tts::googlecloud::configext_t>(options, logif);
+    throw std::runtime_error("Unknown backend: " + backend);
+}
+
+// utterance is interrupted after given delay, time from cancel until speak
+// returns is what user waits for assistant to go quiet
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " <basic|api|cloud> <delay ms> <rounds> [text]\n";
+            return 1;
+        }
+        const std::string backend{argv[1]};
+        const auto delay = std::chrono::milliseconds(std::stoul(argv[2]));
+        const size_t rounds = std::stoul(argv[3]);
+        const std::string text =
+            argc > 4 ? argv[4]
+                     : "To jest dość długie zdanie, które zostanie "
+                       "przerwane, zanim je dokończę. A to jest kolejne.";
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        tts::options_t options;
+        options.player = std::make_shared<tts::playback::Player>(
+            std::make_shared<tts::playback::AlsaSink>());
+        options.synthesizeahead = 1;
+        auto tts = createtts(backend, options, logif);
+
+        using clock = std::chrono::steady_clock;
+        std::chrono::microseconds worst{}, total{};
+        for (size_t round{}; round < rounds; round++)
+        {
+            auto spoken = tts->enqueue(text);
+            std::this_thread::sleep_for(delay);
+            const auto start = clock::now();
+            const auto pending = tts->cancel();
+            const auto completed = spoken.get();
+            const auto latency =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    clock::now() - start);
+            worst = std::max(worst, latency);
+            total += latency;
+            std::cout << round << ": pending: " << pending
+                      << ", completed: " << completed.spoken
+                      << ", barge-in: " << latency.count() << " us\n";
+        }
+        if (rounds > 0)
+            std::cout << "Barge-in mean: " << total.count() / rounds
+                      << " us, worst: " << worst.count() << " us\n";
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
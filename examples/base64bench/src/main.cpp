@@ -0,0 +1,71 @@
+#include "speech/base64.hpp"
+
+#include <boost/beast/core/detail/base64.hpp>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace beast64 = boost::beast::detail::base64;
+namespace speech64 = speech::helpers::base64;
+
+static double measure(const std::string& name, size_t iterations,
+                      size_t bytes, const std::function<size_t()>& decode)
+{
+    size_t outsize{};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t iter{}; iter < iterations; iter++)
+        outsize = decode();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    auto mbps = (double)(bytes * iterations) / elapsed.count() / 1e6;
+    std::cout << name << ": " << mbps << " MB/s, output size: " << outsize
+              << '\n';
+    return mbps;
+}
+
+int main(int argc, char** argv)
+{
+    // default clip of about 1 MB, as minute of mp3 speech
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+    const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    std::mt19937 generator{};
+    std::string audio(size, '\0');
+    for (auto& sign : audio)
+        sign = (char)generator();
+    std::string encoded(beast64::encoded_size(audio.size()), '\0');
+    encoded.resize(
+        beast64::encode(encoded.data(), audio.data(), audio.size()));
+    std::cout << "Audio size: " << audio.size()
+              << ", encoded size: " << encoded.size()
+              << ", iterations: " << iterations << '\n';
+
+    // as previously done in googleapi tts, output sized as input
+    std::string previous(encoded.size(), '\0');
+    auto reference = measure("boost beast", iterations, encoded.size(), [&]() {
+        beast64::decode(previous.data(), encoded.c_str(), previous.size());
+        return previous.size();
+    });
+
+    std::string scalar(beast64::decoded_size(encoded.size()), '\0');
+    measure("scalar", iterations, encoded.size(), [&]() {
+        scalar.resize(speech64::getdecodedsize(encoded));
+        speech64::decodescalar(encoded, scalar);
+        return scalar.size();
+    });
+
+    std::string vector;
+    auto current = measure("vectorized", iterations, encoded.size(), [&]() {
+        vector.resize(speech64::getdecodedsize(encoded));
+        speech64::decode(encoded, vector);
+        return vector.size();
+    });
+
+    std::cout << "Speedup: " << current / reference
+              << "x, output matches: " << std::boolalpha
+              << (vector == audio && scalar == audio) << '\n';
+    return 0;
+}
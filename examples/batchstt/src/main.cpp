@@ -0,0 +1,115 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/stt/batch.hpp"
+#include "speech/stt/interfaces/v1/googlecloud.hpp"
+#include "speech/stt/interfaces/v2/googleapi.hpp"
+#include "speech/stt/interfaces/v2/googlecloud.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+static std::shared_ptr<stt::TextFromVoiceIf>
+    createstt(const std::string& backend, std::shared_ptr<logs::LogIf> logif)
+{
+    if (backend == "v1")
+        return stt::TextFromVoiceFactory::create<
+            stt::v1::googlecloud::TextFromVoice,
+            stt::v1::googlecloud::configmin_t>(
+            {stt::language::polish, {}, logif});
+    if (backend == "v2")
+        return stt::TextFromVoiceFactory::create<
+            stt::v2::googlecloud::TextFromVoice,
+            stt::v2::googlecloud::configmin_t>(
+            {stt::language::polish, {}, logif});
+    if (backend == "api")
+        return stt::TextFromVoiceFactory::create<
+            stt::v2::googleapi::TextFromVoice,
+            stt::v2::googleapi::configmin_t>(
+            {stt::language::polish, {}, logif});
+    throw std::runtime_error("Unknown backend: " + backend);
+}
+
+// directories are expanded to flac and wav files they contain
+static std::vector<stt::batchinput_t> getinputs(int argc, char** argv,
+                                                stt::language lang)
+{
+    std::vector<std::filesystem::path> files;
+    for (int arg{4}; arg < argc; arg++)
+    {
+        std::filesystem::path path{argv[arg]};
+        if (!std::filesystem::is_directory(path))
+        {
+            files.push_back(path);
+            continue;
+        }
+        std::vector<std::filesystem::path> entries;
+        for (const auto& entry : std::filesystem::directory_iterator(path))
+            if (auto ext = entry.path().extension();
+                ext == ".flac" || ext == ".wav")
+                entries.push_back(entry.path());
+        std::sort(entries.begin(), entries.end());
+        files.insert(files.end(), entries.begin(), entries.end());
+    }
+
+    std::vector<stt::batchinput_t> inputs;
+    for (const auto& file : files)
+        inputs.push_back({file, {}, stt::format::flac, lang});
+    return inputs;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 5)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " <v1|v2|api> <concurrency> <pl|en|de> <file or "
+                         "directory>...\n";
+            return 1;
+        }
+        const std::string backend{argv[1]};
+        const size_t concurrency = std::stoul(argv[2]);
+        const std::string code{argv[3]};
+        const auto lang = code == "en"   ? stt::language::english
+                          : code == "de" ? stt::language::german
+                                         : stt::language::polish;
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        stt::BatchTranscriber batch{createstt(backend, logif), concurrency};
+
+        const auto inputs = getinputs(argc, argv, lang);
+        const auto results = batch.run(inputs);
+        for (size_t index{}; index < results.size(); index++)
+        {
+            const auto& result = results[index];
+            std::cout << index << " " << inputs[index].file.native() << ": ";
+            if (!result.error.empty())
+                std::cout << "[ERROR] " << result.error;
+            else if (result.transcript)
+                std::cout << "'" << result.transcript->first << "' ("
+                          << result.transcript->second << "%)";
+            else
+                std::cout << "<not recognized>";
+            std::cout << ", " << result.latency.count() << " ms\n";
+        }
+
+        const auto stats = batch.getstats();
+        std::cout << "Inputs: " << stats.inputs << ", failed: " << stats.failed
+                  << ", concurrency: " << concurrency
+                  << ", wall time: " << stats.elapsed
+                  << " s, audio: " << stats.audio << " s\n"
+                  << "Throughput: " << stats.inputspersec << " files/s, "
+                  << stats.audiopersec << " audio-s/s\n"
+                  << "Latency p50: " << stats.p50.count()
+                  << " ms, p99: " << stats.p99.count() << " ms\n";
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
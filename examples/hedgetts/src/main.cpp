@@ -0,0 +1,104 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/tts/interfaces/googleapi.hpp"
+#include "speech/tts/interfaces/googlebasic.hpp"
+#include "speech/tts/interfaces/googlecloud.hpp"
+#include "speech/tts/interfaces/hedged.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const tts::voice_t voice{tts::language::polish, tts::gender::female,
+                                1};
+
+template <typename T, typename C>
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(std::shared_ptr<logs::LogIf> logif)
+{
+    return tts::TextToVoiceFactory::create<T, C>({voice, logif});
+}
+
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(const std::string& backend, std::shared_ptr<logs::LogIf> logif)
+{
+    if (backend == "basic")
+        return createtts<tts::googlebasic::TextToVoice,
+                         tts::googlebasic::configmin_t>(logif);
+    if (backend == "api")
+        return createtts<tts::googleapi::TextToVoice,
+                         tts::googleapi::configmin_t>(logif);
+    if (backend == "cloud")
+        return createtts<tts::googlecloud::TextToVoice,
+                         tts::googlecloud::configmin_t>(logif);
+    throw std::runtime_error("Unknown backend: " + backend);
+}
+
+// same text synthesized over and over, each round hedged after given delay,
+// shows how often hedge was needed and which backend tends to win
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " <delay ms> <rounds> <basic|api|cloud>...\n";
+            return 1;
+        }
+        const auto delay = std::chrono::milliseconds(std::stoul(argv[1]));
+        const size_t rounds = std::stoul(argv[2]);
+        const std::string text{"To jest zdanie syntezowane na wyścigi."};
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        tts::hedged::backends_t backends;
+        std::vector<std::string> names;
+        for (int arg{3}; arg < argc; arg++)
+        {
+            names.emplace_back(argv[arg]);
+            backends.push_back(createtts(names.back(), logif));
+        }
+        // stats are not part of common interface
+        auto hedged = std::dynamic_pointer_cast<tts::hedged::TextToVoice>(
+            tts::TextToVoiceFactory::create<tts::hedged::TextToVoice,
+                                            tts::hedged::configmin_t>(
+                {backends, {delay, 2}, logif}));
+
+        using clock = std::chrono::steady_clock;
+        for (size_t round{}; round < rounds; round++)
+        {
+            const auto start = clock::now();
+            const auto audio = hedged->synthesize(text);
+            std::cout << round << ": audio: " << audio->size()
+                      << " bytes, latency: "
+                      << std::chrono::duration_cast<
+                             std::chrono::milliseconds>(clock::now() - start)
+                             .count()
+                      << " ms\n";
+        }
+
+        const auto stats = hedged->getstats();
+        std::cout << "Syntheses: " << stats.syntheses
+                  << ", hedge rate: " << stats.hedgerate
+                  << ", hedge win rate: " << stats.hedgewinrate << '\n';
+        for (size_t idx{}; idx < stats.backends.size(); idx++)
+        {
+            const auto& backend = stats.backends[idx];
+            std::cout << names[idx] << ": requests: " << backend.requests
+                      << ", hedges: " << backend.hedges
+                      << ", wins: " << backend.wins
+                      << ", failures: " << backend.failures
+                      << ", cancelled: " << backend.cancelled
+                      << ", p50: " << backend.p50.count()
+                      << " ms, p99: " << backend.p99.count() << " ms\n";
+        }
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
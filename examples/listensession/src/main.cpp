@@ -0,0 +1,99 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/stt/interfaces/v1/googlecloud.hpp"
+#include "speech/stt/interfaces/v2/googleapi.hpp"
+#include "speech/stt/interfaces/v2/googlecloud.hpp"
+#include "speech/stt/session.hpp"
+#include "speech/stt/sources.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static std::shared_ptr<stt::TextFromVoiceIf>
+    createstt(const std::string& backend, std::shared_ptr<logs::LogIf> logif)
+{
+    if (backend == "v1")
+        return stt::TextFromVoiceFactory::create<
+            stt::v1::googlecloud::TextFromVoice,
+            stt::v1::googlecloud::configmin_t>(
+            {stt::language::polish, {}, logif});
+    if (backend == "v2")
+        return stt::TextFromVoiceFactory::create<
+            stt::v2::googlecloud::TextFromVoice,
+            stt::v2::googlecloud::configmin_t>(
+            {stt::language::polish, {}, logif});
+    if (backend == "api")
+        return stt::TextFromVoiceFactory::create<
+            stt::v2::googleapi::TextFromVoice,
+            stt::v2::googleapi::configmin_t>(
+            {stt::language::polish, {}, logif});
+    throw std::runtime_error("Unknown backend: " + backend);
+}
+
+static void print(const char* name, const stt::stagestats_t& stage)
+{
+    std::cout << name << ": depth: " << stage.depth
+              << ", peak: " << stage.peak << ", mean: " << stage.mean.count()
+              << " ms, max: " << stage.max.count() << " ms\n";
+}
+
+// microphone listened to for given time, transcripts are printed in order
+// of speaking while next utterances are already captured
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " <v1|v2|api> <concurrency> <seconds>\n";
+            return 1;
+        }
+        const std::string backend{argv[1]};
+        const size_t concurrency = std::stoul(argv[2]);
+        const auto duration = std::chrono::seconds(std::stoul(argv[3]));
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        stt::sessionconfig_t config;
+        config.source = std::make_shared<stt::capture::AlsaSource>();
+        config.concurrency = concurrency;
+        stt::ListenSession session{
+            createstt(backend, logif), config,
+            [](const stt::sessionresult_t& result) {
+                std::cout << result.utterance << ": ";
+                if (!result.error.empty())
+                    std::cout << "[ERROR] " << result.error;
+                else if (result.transcript)
+                    std::cout << "'" << result.transcript->first << "' ("
+                              << result.transcript->second << "%)";
+                else
+                    std::cout << "<not recognized>";
+                std::cout << ", " << result.latency.count() << " ms\n";
+            }};
+        session.start();
+        std::this_thread::sleep_for(duration);
+        session.stop();
+
+        const auto stats = session.getstats();
+        std::cout << "Utterances: " << stats.utterances
+                  << ", transcripts: " << stats.transcripts
+                  << ", failed: " << stats.failed
+                  << ", retries: " << stats.retries
+                  << ", dropped: " << stats.dropped
+                  << ", callback failures: " << stats.callbackfailures
+                  << ", capture stalled: " << stats.stalled.count()
+                  << " ms\n";
+        print("Queue", stats.queue);
+        print("Recognition", stats.recognition);
+        print("Delivery", stats.delivery);
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
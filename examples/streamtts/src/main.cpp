@@ -0,0 +1,81 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/tts/interfaces/googlecloud.hpp"
+#include "speech/tts/sinks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// same text spoken with whole and then streamed synthesis, shows how much
+// sooner audio starts and whether playback had to wait for stream
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 2)
+        {
+            std::cerr << "Usage: " << argv[0] << " <rounds> [text]\n";
+            return 1;
+        }
+        const size_t rounds = std::stoul(argv[1]);
+        const std::string text =
+            argc > 2 ? argv[2]
+                     : "To jest dłuższa odpowiedź, złożona z kilku zdań. "
+                       "Pierwsze z nich powinno zabrzmieć, zanim kolejne "
+                       "zostaną zsyntezowane. Tak wygląda strumieniowanie.";
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        const tts::voice_t voice{tts::language::polish, tts::gender::female,
+                                 1};
+        auto player = std::make_shared<tts::playback::Player>(
+            std::make_shared<tts::playback::AlsaSink>());
+
+        using clock = std::chrono::steady_clock;
+        for (const auto streaming : {false, true})
+        {
+            tts::options_t options;
+            options.player = player;
+            options.streaming = streaming;
+            // stats are not part of common interface
+            auto tts = std::dynamic_pointer_cast<tts::googlecloud::TextToVoice>(
+                tts::TextToVoiceFactory::create<
+                    tts::googlecloud::TextToVoice,
+                    tts::googlecloud::configext_t>({voice, options, logif}));
+            for (size_t round{}; round < rounds; round++)
+            {
+                const auto start = clock::now();
+                const auto spoken = tts->enqueue(text).get();
+                std::cout << (streaming ? "streamed" : "whole") << ' ' << round
+                          << ": spoken: " << spoken.spoken
+                          << ", first audio: "
+                          << (spoken.firstaudio ? spoken.firstaudio->count()
+                                                : -1)
+                          << " ms, total: "
+                          << std::chrono::duration_cast<
+                                 std::chrono::milliseconds>(clock::now() -
+                                                            start)
+                                 .count()
+                          << " ms\n";
+            }
+            if (streaming)
+            {
+                const auto stats = tts->getstreamstats();
+                std::cout << "Streams: " << stats.streams
+                          << ", time to first audio: "
+                          << stats.firstaudio.count()
+                          << " ms (worst: " << stats.firstaudiomax.count()
+                          << " ms), underruns: " << stats.underruns
+                          << ", starved: " << stats.starved.count()
+                          << " ms\n";
+            }
+        }
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
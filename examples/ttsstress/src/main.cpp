@@ -0,0 +1,157 @@
+#include "logs/interfaces/console/logs.hpp"
+#include "speech/tts/interfaces/googleapi.hpp"
+#include "speech/tts/interfaces/googlebasic.hpp"
+#include "speech/tts/interfaces/googlecloud.hpp"
+#include "speech/tts/sinks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const std::vector<tts::voice_t> voices = {
+    {tts::language::polish, tts::gender::female, 1},
+    {tts::language::polish, tts::gender::male, 1},
+    {tts::language::english, tts::gender::female, 1},
+    {tts::language::german, tts::gender::male, 1}};
+
+static const std::vector<std::string> texts = {
+    "Jestem twoim asystentem, co mam zrobić?", "I am your assistant.",
+    "Ich bin dein Assistent.", "Powiedz \"cześć\", a odpowiem."};
+
+// [synthesized, spoken, voice changes, failed calls]
+struct counters_t
+{
+    std::atomic<uint64_t> synthesized;
+    std::atomic<uint64_t> spoken;
+    std::atomic<uint64_t> voices;
+    std::atomic<uint64_t> failed;
+};
+
+template <typename T, typename C>
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(const tts::options_t& options,
+              std::shared_ptr<logs::LogIf> logif)
+{
+    return tts::TextToVoiceFactory::create<T, C>(
+        {voices.front(), options, logif});
+}
+
+static std::shared_ptr<tts::TextToVoiceIf>
+    createtts(const std::string& backend, const tts::options_t& options,
+              std::shared_ptr<logs::LogIf> logif)
+{
+    if (backend == "basic")
+        return createtts<tts::googlebasic::TextToVoice,
+                         tts::googlebasic::configext_t>(options, logif);
+    if (backend == "api")
+        return createtts<tts::googleapi::TextToVoice,
+                         tts::googleapi::configext_t>(options, logif);
+    if (backend == "cloud")
+        return createtts<tts::googlecloud::TextToVoice,
+                         tts::googlecloud::configext_t>(options, logif);
+    throw std::runtime_error("Unknown backend: " + backend);
+}
+
+static bool isknown(const tts::voice_t& voice)
+{
+    return std::find(voices.begin(), voices.end(), voice) != voices.end();
+}
+
+// every worker mixes synthesis with its own voice, synthesis and speech
+// with default voice and default voice changes, all on same instance
+static void work(tts::TextToVoiceIf& tts, size_t worker, size_t iterations,
+                 counters_t& counters)
+{
+    for (size_t iter{}; iter < iterations; iter++)
+    {
+        const auto& text = texts[(worker + iter) % texts.size()];
+        const auto& voice = voices[(worker + iter) % voices.size()];
+        try
+        {
+            switch (iter % 4)
+            {
+                case 0:
+                case 1:
+                    if (auto audio = tts.synthesize(text, voice);
+                        !audio || audio->empty())
+                        throw std::runtime_error("no audio synthesized");
+                    counters.synthesized++;
+                    break;
+                case 2:
+                    if (!tts.speak(text))
+                        throw std::runtime_error("text not spoken");
+                    counters.spoken++;
+                    break;
+                case 3:
+                    tts.setvoice(voice);
+                    if (!isknown(tts.getvoice()))
+                        throw std::runtime_error("voice corrupted");
+                    counters.voices++;
+                    break;
+            }
+        }
+        catch (std::exception& err)
+        {
+            std::cerr << "Worker " << worker << ", iteration " << iter
+                      << ": " << err.what() << '\n';
+            counters.failed++;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " <basic|api|cloud> <threads> <iterations>\n";
+            return 1;
+        }
+        const std::string backend{argv[1]};
+        const size_t threads = std::stoul(argv[2]);
+        const size_t iterations = std::stoul(argv[3]);
+
+        auto logif = logs::Factory::create<logs::console::Log,
+                                           logs::console::config_t>(
+            {logs::level::warning, logs::time::hide, logs::tags::hide});
+        auto sink = std::make_shared<tts::playback::NullSink>();
+        tts::options_t options;
+        options.queuesize = threads;
+        options.player = std::make_shared<tts::playback::Player>(sink);
+        auto tts = createtts(backend, options, logif);
+
+        counters_t counters{};
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> workers;
+        for (size_t worker{}; worker < threads; worker++)
+            workers.push_back(std::async(std::launch::async, [&, worker]() {
+                work(*tts, worker, iterations, counters);
+            }));
+        for (auto& worker : workers)
+            worker.get();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        const auto calls = threads * iterations;
+        std::cout << "Threads: " << threads << ", calls: " << calls
+                  << ", synthesized: " << counters.synthesized
+                  << ", spoken: " << counters.spoken
+                  << ", voice changes: " << counters.voices
+                  << ", failed: " << counters.failed << '\n'
+                  << "Wall time: " << elapsed.count()
+                  << " s, calls/s: " << (double)calls / elapsed.count()
+                  << ", samples played: " << sink->getsamples() << '\n';
+        return counters.failed ? 1 : 0;
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << "[ERROR] " << err.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,113 @@
+#include "speech/stt/sources.hpp"
+#include "speech/stt/vad.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace stt::capture;
+
+// kernels are run on 10 ms frames, as done by endpointer
+static constexpr size_t frameSize{sampleRate / 100};
+// audio is fed to endpointer in 20 ms chunks, as done by capture
+static constexpr size_t chunkSize{sampleRate / 50};
+
+static double measure(const std::string& name, size_t iterations,
+                      const std::vector<int16_t>& audio,
+                      const std::function<uint64_t(std::span<const int16_t>)>&
+                          kernel)
+{
+    uint64_t result{};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t iter{}; iter < iterations; iter++)
+        for (size_t pos{}; pos + frameSize <= audio.size(); pos += frameSize)
+            result += kernel({audio.data() + pos, frameSize});
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    auto msps = (double)(audio.size() * iterations) / elapsed.count() / 1e6;
+    std::cout << name << ": " << msps << " Msamples/s, result: " << result
+              << '\n';
+    return msps;
+}
+
+static double getms(size_t samples)
+{
+    return (double)samples * 1000 / sampleRate;
+}
+
+static void endpoint(const std::string& name, const vadconfig_t& config,
+                     const std::vector<int16_t>& audio, size_t speechend)
+{
+    Endpointer endpointer{config};
+    std::vector<int16_t> utterance;
+    size_t started{}, ended{};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t pos{}; pos < audio.size() && !ended; pos += chunkSize)
+    {
+        auto size = std::min(chunkSize, audio.size() - pos);
+        auto event = endpointer.process({audio.data() + pos, size}, utterance);
+        if (event == vadevent::started)
+            started = pos + size;
+        else if (event == vadevent::ended)
+            ended = pos + size;
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << name << ": onset at " << getms(started)
+              << " ms, end decided at " << getms(ended) << " ms ("
+              << getms(ended - std::min(ended, speechend))
+              << " ms after recording), utterance " << getms(utterance.size())
+              << " ms, noise floor "
+              << 10 * std::log10(endpointer.getnoisefloor() / 32768 / 32768)
+              << " dBFS, processing " << elapsed.count() << " us\n";
+}
+
+int main(int argc, char** argv)
+{
+    const std::string file =
+        argc > 1 ? argv[1] : "../scripts/audio/recording.flac";
+    const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 2000;
+
+    FileSource source{file};
+    if (!source.open())
+    {
+        std::cerr << "Cannot decode audio file: " << file << '\n';
+        return 1;
+    }
+    std::vector<int16_t> audio;
+    std::vector<int16_t> chunk(chunkSize);
+    while (auto size = source.read(chunk))
+        audio.insert(audio.end(), chunk.begin(), chunk.begin() + (long)size);
+    source.close();
+    std::cout << "Audio: " << file << ", duration: " << getms(audio.size())
+              << " ms, iterations: " << iterations << '\n';
+
+    auto scalar = measure("energy scalar", iterations, audio, getenergyscalar);
+    auto vector = measure("energy vectorized", iterations, audio, getenergy);
+    std::cout << "Energy speedup: " << vector / scalar << "x\n";
+    scalar = measure("zero crossings scalar", iterations, audio,
+                     getzerocrossingsscalar);
+    vector =
+        measure("zero crossings vectorized", iterations, audio,
+                getzerocrossings);
+    std::cout << "Zero crossings speedup: " << vector / scalar << "x\n";
+
+    // recording is followed by quiet room noise, as microphone would give
+    // while sox waits for its fixed trailing silence interval
+    const auto speechend = audio.size();
+    std::mt19937 generator{};
+    std::normal_distribution<double> noise{0, 30};
+    for (size_t pos{}; pos < 3 * sampleRate; pos++)
+        audio.push_back((int16_t)noise(generator));
+
+    endpoint("fast", getvadconfig(endpointing::fast), audio, speechend);
+    endpoint("balanced", getvadconfig(endpointing::balanced), audio,
+             speechend);
+    endpoint("accurate", getvadconfig(endpointing::accurate), audio,
+             speechend);
+    return 0;
+}
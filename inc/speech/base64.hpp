@@ -0,0 +1,29 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace speech::helpers::base64
+{
+
+// exact number of decoded bytes, trailing padding taken into account
+size_t getdecodedsize(std::string_view);
+// output must be sized with getdecodedsize, false on malformed input
+bool decode(std::string_view, std::span<char>);
+// portable implementation, used for input tail and as fallback
+bool decodescalar(std::string_view, std::span<char>);
+
+// decodes content arriving in pieces, appending to output as it goes
+class StreamDecoder
+{
+  public:
+    bool decode(std::string_view, std::string&);
+    bool finish(std::string&);
+
+  private:
+    // signs of incomplete quantum left from previous piece
+    std::string pending;
+};
+
+} // namespace speech::helpers::base64
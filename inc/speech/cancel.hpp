@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace speech::helpers
+{
+
+using deadline_t = std::optional<std::chrono::steady_clock::time_point>;
+
+// state of one call, tripped by its owner or expired by its deadline; work
+// checks it between steps and blocking operations subscribe callbacks that
+// interrupt them while they block
+class CancelToken
+{
+  public:
+    explicit CancelToken(deadline_t = std::nullopt);
+    ~CancelToken();
+    CancelToken(const CancelToken&) = delete;
+    CancelToken(CancelToken&&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+    CancelToken& operator=(CancelToken&&) = delete;
+
+    // false when token was already cancelled
+    bool cancel();
+    // true also once deadline has passed
+    bool iscancelled() const;
+    deadline_t getdeadline() const;
+    // callback is run once on cancelling thread, at once when token is
+    // already cancelled; it must not block nor use this token
+    uint64_t subscribe(std::function<void()>&&);
+    // once it returns callback is neither running nor will be run
+    void unsubscribe(uint64_t);
+
+    // true once result is ready, false as soon as token is cancelled or its
+    // deadline passes, result is then left to finish on its own
+    template <typename T>
+    bool wait(const std::future<T>& result) const
+    {
+        static constexpr std::chrono::milliseconds step{1};
+        while (result.wait_for(step) != std::future_status::ready)
+            if (iscancelled())
+                return false;
+        return true;
+    }
+
+  private:
+    friend class Canceller;
+
+    const deadline_t deadline;
+    mutable std::mutex mtx;
+    std::atomic<bool> cancelled{false};
+    uint64_t nextid{};
+    std::map<uint64_t, std::function<void()>> callbacks;
+    // token this one is cancelled with, and its callback doing so
+    std::weak_ptr<CancelToken> parent;
+    uint64_t link{};
+};
+
+// callback subscribed to token for lifetime of this object, none is made
+// for null token
+class CancelCallback
+{
+  public:
+    CancelCallback(std::shared_ptr<CancelToken>, std::function<void()>&&);
+    ~CancelCallback();
+    CancelCallback(const CancelCallback&) = delete;
+    CancelCallback(CancelCallback&&) = delete;
+    CancelCallback& operator=(const CancelCallback&) = delete;
+    CancelCallback& operator=(CancelCallback&&) = delete;
+
+  private:
+    const std::shared_ptr<CancelToken> token;
+    const uint64_t id;
+};
+
+// source of tokens of one instance, cancelling trips tokens of all its
+// calls in flight while calls started afterwards get fresh ones, so other
+// instances and later calls are never affected
+class Canceller
+{
+  public:
+    Canceller() = default;
+    Canceller(const Canceller&) = delete;
+    Canceller(Canceller&&) = delete;
+    Canceller& operator=(const Canceller&) = delete;
+    Canceller& operator=(Canceller&&) = delete;
+
+    // token of one call, zero timeout gives token without deadline; call
+    // made within scope of another one is also cancelled with it and bound
+    // by its deadline
+    std::shared_ptr<CancelToken> gettoken(std::chrono::milliseconds = {});
+    // returns whether any call was in flight
+    bool cancel();
+
+  private:
+    std::mutex mtx;
+    std::vector<std::weak_ptr<CancelToken>> tokens;
+};
+
+// token of call made on this thread, transfers started by helpers while
+// scope exists are aborted with it and bound by its deadline
+class CancelScope
+{
+  public:
+    explicit CancelScope(std::shared_ptr<CancelToken>);
+    ~CancelScope();
+    CancelScope(const CancelScope&) = delete;
+    CancelScope(CancelScope&&) = delete;
+    CancelScope& operator=(const CancelScope&) = delete;
+    CancelScope& operator=(CancelScope&&) = delete;
+
+    static std::shared_ptr<CancelToken> gettoken();
+
+  private:
+    const std::shared_ptr<CancelToken> previous;
+};
+
+} // namespace speech::helpers
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "shell/interfaces/shell.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace speech::helpers
+{
+
+// external player or recorder run by shell as process that records its own
+// pid, so owner kills exactly that process instead of every one of same
+// name, and without spawning another shell to do it
+class Command
+{
+  public:
+    explicit Command(std::shared_ptr<shell::ShellIf>);
+    ~Command();
+    Command(const Command&) = delete;
+    Command(Command&&) = delete;
+    Command& operator=(const Command&) = delete;
+    Command& operator=(Command&&) = delete;
+
+    // blocks until process exits, command killed before it started is
+    // not run at all
+    int run(const std::string&);
+    // may be called from any thread, false when nothing was running
+    bool kill();
+
+  private:
+    const std::shared_ptr<shell::ShellIf> shell;
+    const std::filesystem::path pidfile;
+    const std::filesystem::path stopfile;
+    std::mutex mtx;
+    bool killed{false};
+};
+
+} // namespace speech::helpers
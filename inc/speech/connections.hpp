@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace speech::helpers
+{
+
+// [service account key, endpoint overriding default one of service, grpc
+// channels opened per connection, keepalive ping interval (0 disables),
+// gzip compression of requests]
+struct connconfig_t
+{
+    std::filesystem::path keyfile{"../conf/key.json"};
+    std::string endpoint;
+    int channels{4};
+    std::chrono::seconds keepalive{30};
+    bool compression{false};
+};
+
+// [connections created, instances served with already made connection]
+struct connstats_t
+{
+    uint64_t created;
+    uint64_t reused;
+};
+
+// process wide registry of google-cloud connections, instances of same
+// service, location and config share channels and credentials, so only
+// first one pays for reading key file and opening http/2 channels
+class Connections
+{
+  public:
+    Connections() = default;
+    Connections(const Connections&) = delete;
+    Connections(Connections&&) = delete;
+    Connections& operator=(const Connections&) = delete;
+    Connections& operator=(Connections&&) = delete;
+
+    template <typename T>
+    std::shared_ptr<T> get(const std::string& service,
+                           const std::string& location,
+                           const connconfig_t& config,
+                           const std::function<std::shared_ptr<T>()>& create)
+    {
+        return std::static_pointer_cast<T>(
+            getany(service, location, config,
+                   std::function<std::shared_ptr<void>()>{create}));
+    }
+
+    connstats_t getstats();
+    static std::shared_ptr<Connections> getdefault();
+
+  private:
+    std::mutex mtx;
+    std::map<std::string, std::shared_ptr<void>> connections;
+    connstats_t stats{};
+
+    std::shared_ptr<void>
+        getany(const std::string&, const std::string&, const connconfig_t&,
+               const std::function<std::shared_ptr<void>()>&);
+};
+
+} // namespace speech::helpers
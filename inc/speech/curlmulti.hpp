@@ -0,0 +1,56 @@
+#pragma once
+
+#include "speech/curlpool.hpp"
+
+#include <curl/curl.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace speech::helpers
+{
+
+class CurlMulti
+{
+  public:
+    using completion_t = std::function<void(CURLcode)>;
+
+    CurlMulti();
+    ~CurlMulti();
+    CurlMulti(const CurlMulti&) = delete;
+    CurlMulti(CurlMulti&&) = delete;
+    CurlMulti& operator=(const CurlMulti&) = delete;
+    CurlMulti& operator=(CurlMulti&&) = delete;
+
+    bool submit(CurlPool::handle_t&&, completion_t&&);
+    size_t inflight() const;
+
+    static std::shared_ptr<CurlMulti> getdefault();
+
+  private:
+    struct Transfer
+    {
+        CurlPool::handle_t handle;
+        completion_t complete;
+    };
+
+    CURLM* multi;
+    std::mutex mtx;
+    std::vector<Transfer> pending;
+    std::unordered_map<CURL*, Transfer> active;
+    std::atomic<size_t> transfers{};
+    std::atomic<bool> running{true};
+    std::thread engine;
+
+    void run();
+    void addpending();
+    void collectdone();
+    void abortall();
+};
+
+} // namespace speech::helpers
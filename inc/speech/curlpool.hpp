@@ -0,0 +1,54 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace speech::helpers
+{
+
+// [max idle handles kept, time after which idle handle is closed]
+using poolconfig_t = std::tuple<size_t, std::chrono::seconds>;
+
+class CurlPool : public std::enable_shared_from_this<CurlPool>
+{
+  public:
+    using handle_t = std::unique_ptr<CURL, std::function<void(CURL*)>>;
+
+    explicit CurlPool(const poolconfig_t&);
+    ~CurlPool();
+    CurlPool(const CurlPool&) = delete;
+    CurlPool(CurlPool&&) = delete;
+    CurlPool& operator=(const CurlPool&) = delete;
+    CurlPool& operator=(CurlPool&&) = delete;
+
+    handle_t acquire();
+    size_t idlehandles();
+
+    static std::shared_ptr<CurlPool> getdefault();
+
+  private:
+    using idle_t = std::pair<CURL*, std::chrono::steady_clock::time_point>;
+
+    const size_t maxidle;
+    const std::chrono::seconds idletimeout;
+    CURLSH* share;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> sharelocks;
+    std::mutex mtx;
+    std::deque<idle_t> idle;
+
+    void setup(CURL*);
+    void release(CURL*);
+    void evictidle();
+
+    static void lockshare(CURL*, curl_lock_data, curl_lock_access, void*);
+    static void unlockshare(CURL*, curl_lock_data, void*);
+};
+
+} // namespace speech::helpers
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "google/cloud/options.h"
+#include "speech/cancel.hpp"
+#include "speech/connections.hpp"
+
+namespace speech::helpers
+{
+
+// credentials, channel pool, keepalive and compression options of config,
+// credentials are made once per key file and shared by all connections
+google::cloud::Options getgrpcoptions(const connconfig_t&);
+// per call options, every attempt of call is bound by deadline of token
+google::cloud::Options getcalloptions(const std::shared_ptr<CancelToken>&);
+
+} // namespace speech::helpers
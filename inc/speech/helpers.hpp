@@ -1,12 +1,43 @@
 #pragma once
 
+#include "speech/curlpool.hpp"
+
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace speech::helpers
 {
 
+// [requests done, request body bytes sent in place, response bytes copied,
+// response buffer allocations]
+struct transferstats_t
+{
+    uint64_t requests;
+    uint64_t inplacebytes;
+    uint64_t copiedbytes;
+    uint64_t allocations;
+};
+
+struct TransferCounters;
+
+// fills buffer with next chunk of data and returns its size, 0 ends stream
+using chunkreader_t = std::function<size_t(char*, size_t)>;
+// consumes next chunk of response as received, false aborts transfer
+using chunkwriter_t = std::function<bool(std::string_view)>;
+// takes outcome of non-blocking transfer, called once it ends, on engine
+// thread, or at once on caller thread when transfer cannot start
+using completion_t = std::function<void(bool)>;
+
+// uploaded audio is flac file or raw 16 kHz linear16 samples
+enum class audiotype
+{
+    flac,
+    linear16
+};
+
 class HelpersIf
 {
   public:
@@ -14,13 +45,32 @@ class HelpersIf
     {}
     virtual bool uploadData(const std::string&, const std::string&,
                             std::string&) = 0;
+    virtual bool uploadData(const std::string&, std::string_view,
+                            std::string&) = 0;
+    virtual bool uploadData(const std::string&, std::string_view,
+                            chunkwriter_t) = 0;
+    virtual bool uploadData(const std::string&, audiotype, std::string_view,
+                            std::string&) = 0;
     virtual bool downloadFile(const std::string&, const std::string&,
                               const std::string&) = 0;
+    virtual bool downloadData(const std::string&, const std::string&,
+                              std::string&) = 0;
     virtual bool uploadFile(const std::string&, const std::string&,
                             std::string&) = 0;
-    virtual bool createasync(std::function<void()>&&) = 0;
-    virtual bool waitasync() = 0;
-    virtual bool killasync() = 0;
+    virtual bool uploadStream(const std::string&, chunkreader_t,
+                              std::string&) = 0;
+    virtual bool uploadStream(const std::string&, audiotype, chunkreader_t,
+                              std::string&) = 0;
+    // non-blocking transfers, all served by one curl multi engine thread,
+    // request body is owned by transfer until it completes
+    virtual void uploadDataAsync(const std::string&, std::string,
+                                 chunkwriter_t, completion_t) = 0;
+    virtual void uploadDataAsync(const std::string&, audiotype,
+                                 std::shared_ptr<const std::string>,
+                                 chunkwriter_t, completion_t) = 0;
+    virtual void downloadFileAsync(const std::string&, const std::string&,
+                                   const std::string&, completion_t) = 0;
+    virtual transferstats_t getstats() const = 0;
 };
 
 class Helpers : public HelpersIf
@@ -28,19 +78,37 @@ class Helpers : public HelpersIf
   public:
     bool uploadData(const std::string&, const std::string&,
                     std::string&) override;
+    bool uploadData(const std::string&, std::string_view,
+                    std::string&) override;
+    bool uploadData(const std::string&, std::string_view,
+                    chunkwriter_t) override;
+    bool uploadData(const std::string&, audiotype, std::string_view,
+                    std::string&) override;
     bool uploadFile(const std::string&, const std::string&,
                     std::string&) override;
+    bool uploadStream(const std::string&, chunkreader_t,
+                      std::string&) override;
+    bool uploadStream(const std::string&, audiotype, chunkreader_t,
+                      std::string&) override;
     bool downloadFile(const std::string&, const std::string&,
                       const std::string&) override;
-    bool createasync(std::function<void()>&&) override;
-    bool waitasync() override;
-    bool killasync() override;
+    bool downloadData(const std::string&, const std::string&,
+                      std::string&) override;
+    void uploadDataAsync(const std::string&, std::string, chunkwriter_t,
+                         completion_t) override;
+    void uploadDataAsync(const std::string&, audiotype,
+                         std::shared_ptr<const std::string>, chunkwriter_t,
+                         completion_t) override;
+    void downloadFileAsync(const std::string&, const std::string&,
+                           const std::string&, completion_t) override;
+    transferstats_t getstats() const override;
 
   private:
     friend class HelpersFactory;
-    Helpers() = default;
+    explicit Helpers(std::shared_ptr<CurlPool>);
 
-    bool isasyncrunning() const;
+    const std::shared_ptr<CurlPool> pool;
+    const std::shared_ptr<TransferCounters> counters;
 };
 
 class HelpersFactory
@@ -53,6 +121,7 @@ class HelpersFactory
     HelpersFactory& operator=(HelpersFactory&&) = delete;
 
     static std::shared_ptr<HelpersIf> create();
+    static std::shared_ptr<HelpersIf> create(const poolconfig_t&);
 };
 
 std::string str(const auto& value)
@@ -64,5 +133,7 @@ std::string str(const auto& value)
 }
 
 std::string getrecordingcmd(const std::string&, const std::string&);
+std::string getplaybackcmd(const std::string&);
+std::vector<std::string> splitsentences(const std::string&);
 
 } // namespace speech::helpers
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace speech::helpers
+{
+
+// read-only view of whole file, pages are loaded by kernel as they are read
+class MappedFile
+{
+  public:
+    explicit MappedFile(const std::string&);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    explicit operator bool() const;
+    std::string_view view() const;
+
+  private:
+    void* addr;
+    size_t size{};
+    bool mapped{false};
+};
+
+} // namespace speech::helpers
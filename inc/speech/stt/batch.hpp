@@ -0,0 +1,71 @@
+#pragma once
+
+#include "speech/stt/interfaces/textfromvoice.hpp"
+#include "speech/threadpool.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace stt
+{
+
+// audio file, or buffer in memory when audio is not empty
+struct batchinput_t
+{
+    std::filesystem::path file;
+    std::vector<std::byte> audio;
+    format type{format::flac};
+    language lang{language::polish};
+};
+
+struct batchresult_t
+{
+    std::optional<transcript_t> transcript;
+    // reason of failed request, empty when backend answered
+    std::string error;
+    std::chrono::milliseconds latency;
+    double duration;
+};
+
+// [inputs done, failed requests, wall time, audio seconds, inputs and audio
+// seconds per wall second, median and 99th percentile request latency]
+struct batchstats_t
+{
+    size_t inputs;
+    size_t failed;
+    double elapsed;
+    double audio;
+    double inputspersec;
+    double audiopersec;
+    std::chrono::milliseconds p50;
+    std::chrono::milliseconds p99;
+};
+
+// fans inputs out over bounded number of concurrent transcribe calls on
+// single backend, results are returned in order of inputs
+class BatchTranscriber
+{
+  public:
+    BatchTranscriber(std::shared_ptr<TextFromVoiceIf>, size_t);
+
+    std::vector<batchresult_t> run(const std::vector<batchinput_t>&);
+    // summary of last run
+    batchstats_t getstats() const;
+
+  private:
+    const std::shared_ptr<TextFromVoiceIf> stt;
+    const size_t concurrency;
+    const std::shared_ptr<speech::helpers::ThreadPool> pool;
+    batchstats_t stats{};
+
+    batchresult_t transcribe(const batchinput_t&) const;
+};
+
+// length in seconds of flac, wav or raw linear16 audio, 0 when unknown
+double getaudioduration(std::span<const std::byte>, format);
+
+} // namespace stt
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "speech/stt/vad.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace stt::capture
+{
+
+// recognizers are fed with 16 kHz mono signed 16-bit little endian samples
+static constexpr uint32_t sampleRate{16000};
+
+// lock-free queue of samples for exactly one producer and one consumer,
+// capacity is rounded up to power of two
+class RingBuffer
+{
+  public:
+    explicit RingBuffer(size_t);
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // both return number of samples actually transferred
+    size_t write(std::span<const int16_t>);
+    size_t read(std::span<int16_t>);
+    size_t available() const;
+    size_t capacity() const;
+
+  private:
+    std::vector<int16_t> buffer;
+    const size_t mask;
+    // indexes only grow, kept on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> head{};
+    alignas(64) std::atomic<size_t> tail{};
+};
+
+class SourceIf
+{
+  public:
+    virtual ~SourceIf() = default;
+    virtual bool open() = 0;
+    // blocks until samples are captured, 0 once source is exhausted
+    virtual size_t read(std::span<int16_t>) = 0;
+    virtual void close() = 0;
+    // realtime source cannot wait for reader, its samples are dropped on
+    // full buffer, others are held until there is space for them
+    virtual bool isrealtime() const = 0;
+};
+
+// [samples captured, samples of realtime source dropped on full buffer]
+struct capturestats_t
+{
+    uint64_t captured;
+    uint64_t dropped;
+};
+
+// pulls one utterance from source on own thread into ring buffer, ends when
+// source is exhausted, stop is requested, duration limit is reached or
+// endpointer decides speech is over; with endpointer only utterance audio
+// is passed on
+class Capture
+{
+  public:
+    explicit Capture(std::shared_ptr<SourceIf>,
+                     std::optional<vadconfig_t> = std::nullopt,
+                     std::chrono::milliseconds = std::chrono::seconds{15});
+    ~Capture();
+    Capture(const Capture&) = delete;
+    Capture(Capture&&) = delete;
+    Capture& operator=(const Capture&) = delete;
+    Capture& operator=(Capture&&) = delete;
+
+    bool start();
+    void stop();
+    // may be called from other thread, reader gets no more samples and
+    // producer ends after chunk being captured, stop still joins it
+    void cancel();
+    // blocks until samples are available, 0 once capture ended and all
+    // captured samples were consumed
+    size_t read(std::span<int16_t>);
+    capturestats_t getstats() const;
+
+  private:
+    const std::shared_ptr<SourceIf> source;
+    const bool realtime;
+    const uint64_t limit;
+    std::optional<Endpointer> endpointer;
+    RingBuffer ring;
+    std::atomic<bool> running{false};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> cancelled{false};
+    // bumped on every write, consumer sleeps on it when ring is empty
+    std::atomic<uint32_t> signal{};
+    // bumped on every read, producer of non-realtime source sleeps on it
+    // when ring is full
+    std::atomic<uint32_t> space{};
+    std::atomic<uint64_t> captured{};
+    std::atomic<uint64_t> dropped{};
+    std::thread producer;
+
+    void run();
+    void notify();
+    void release();
+};
+
+} // namespace stt::capture
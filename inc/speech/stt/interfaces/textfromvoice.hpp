@@ -1,8 +1,20 @@
 #pragma once
 
+#include "speech/connections.hpp"
+#include "speech/stt/capture.hpp"
+
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace stt
 {
@@ -14,6 +26,40 @@ enum class language
     german
 };
 
+enum class mode
+{
+    recorded,
+    streaming
+};
+
+// flac file content or raw 16 kHz mono linear16 samples
+enum class format
+{
+    flac,
+    linear16
+};
+
+struct options_t
+{
+    // recorded: utterance captured completely before being recognized
+    // streaming: audio sent to recognizer while still being captured
+    mode listening{mode::recorded};
+    // streaming: receives hypotheses before final transcript is ready
+    std::function<void(const std::string&)> interim;
+    // audio captured in process as raw samples instead of running recorder
+    std::shared_ptr<capture::SourceIf> source;
+    // captured utterance is cut by voice activity detection, whole source
+    // audio is taken when not set
+    std::optional<capture::vadconfig_t> vad{capture::vadconfig_t{}};
+    // googlecloud only, connection is shared by instances of same config
+    speech::helpers::connconfig_t connection;
+    // recognition request not done in time is aborted, 0 waits for it
+    std::chrono::milliseconds timeout{0};
+    // listening in several languages ends once any transcript reaches this
+    // confidence, 100 waits for all of them
+    uint32_t confidence{90};
+};
+
 using transcript_t = std::pair<std::string, uint32_t>;
 
 class TextFromVoiceIf
@@ -22,6 +68,26 @@ class TextFromVoiceIf
     virtual ~TextFromVoiceIf() = default;
     virtual transcript_t listen() = 0;
     virtual transcript_t listen(language) = 0;
+    // one utterance recognized in all given languages at once, most
+    // confident transcript is returned
+    virtual transcript_t listen(const std::vector<language>&) = 0;
+    // single recognition of given audio, no microphone and no retries;
+    // nullopt when no speech was recognized or call was cancelled, failed
+    // request throws
+    virtual std::optional<transcript_t>
+        transcribe(std::span<const std::byte>, format, language) = 0;
+    // flac is sent as is, wav is converted to raw samples first
+    std::optional<transcript_t> transcribe(const std::filesystem::path&,
+                                           language);
+    // recognitions run concurrently on shared pool and share client
+    // connection of this instance, number in flight is bounded and caller
+    // runs one itself over that; instance has to outlive returned future
+    std::future<std::optional<transcript_t>>
+        transcribeasync(std::vector<std::byte>, format, language);
+    // capture of this instance stops at once and listen or transcribe calls
+    // in flight return without transcript, later calls are not affected
+    virtual void cancel() = 0;
+    // kills every external recorder on host, cancel() stops only own one
     static void kill();
 };
 
@@ -15,7 +15,10 @@ using configmin_t =
 using configall_t =
     std::tuple<language, std::string, std::shared_ptr<shell::ShellIf>,
                std::shared_ptr<logs::LogIf>>;
-using config_t = std::variant<std::monostate, configmin_t, configall_t>;
+using configext_t = std::tuple<language, std::string, options_t,
+                               std::shared_ptr<logs::LogIf>>;
+using config_t =
+    std::variant<std::monostate, configmin_t, configall_t, configext_t>;
 
 class TextFromVoice : public TextFromVoiceIf
 {
@@ -24,6 +27,11 @@ class TextFromVoice : public TextFromVoiceIf
 
     transcript_t listen() override;
     transcript_t listen(language) override;
+    transcript_t listen(const std::vector<language>&) override;
+    std::optional<transcript_t> transcribe(std::span<const std::byte>, format,
+                                           language) override;
+    void cancel() override;
+    using TextFromVoiceIf::transcribe;
 
   private:
     friend class stt::TextFromVoiceFactory;
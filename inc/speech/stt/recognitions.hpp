@@ -0,0 +1,25 @@
+#pragma once
+
+#include "speech/cancel.hpp"
+#include "speech/stt/interfaces/textfromvoice.hpp"
+
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace stt
+{
+
+using recognition_t = std::future<std::optional<transcript_t>>;
+
+// recognitions of one utterance in several languages, first transcript of
+// at least given confidence is taken at once, otherwise most confident one
+// once all have ended; returns it with index of its recognition, error of
+// failed one is rethrown only when no other gave transcript; recognitions
+// still running are left behind when taken early or token is cancelled
+std::optional<std::pair<size_t, transcript_t>>
+    getbest(std::vector<recognition_t>&, uint32_t,
+            const speech::helpers::CancelToken&);
+
+} // namespace stt
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "logs/interfaces/logs.hpp"
+#include "shell/interfaces/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/command.hpp"
+#include "speech/helpers.hpp"
+#include "speech/stt/capture.hpp"
+#include "speech/threadpool.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace stt
+{
+
+// audio of one utterance read by recognizer while it is recorded, either
+// from file being written by external recorder or captured from source;
+// both are interrupted at once when token is cancelled
+class Recording
+{
+  public:
+    // recorder is run by shell with given command, writing to given file
+    Recording(std::shared_ptr<logs::LogIf>, std::shared_ptr<shell::ShellIf>,
+              const std::string&, const std::filesystem::path&,
+              std::shared_ptr<speech::helpers::CancelToken>);
+    Recording(std::shared_ptr<logs::LogIf>, std::shared_ptr<shell::ShellIf>,
+              std::shared_ptr<capture::SourceIf>,
+              std::optional<capture::vadconfig_t>,
+              std::shared_ptr<speech::helpers::CancelToken>);
+    ~Recording();
+    Recording(const Recording&) = delete;
+    Recording(Recording&&) = delete;
+    Recording& operator=(const Recording&) = delete;
+    Recording& operator=(Recording&&) = delete;
+
+    // blocks until audio is available, 0 once recording ended and all of
+    // it was read or it was cancelled
+    size_t read(char*, size_t);
+    // transcript is already known, rest of utterance is not needed
+    void stop();
+    // recorder writes flac file, captured audio is raw samples
+    speech::helpers::audiotype gettype() const;
+
+  private:
+    const std::shared_ptr<logs::LogIf> logif;
+    const std::filesystem::path path;
+    std::atomic<bool> finished{false};
+    std::atomic<bool> cancelled{false};
+    std::ifstream ifs;
+    speech::helpers::Command command;
+    speech::helpers::TaskGroup tasks{
+        speech::helpers::ThreadPool::getdefault(), 1};
+    std::future<void> recorder;
+    std::unique_ptr<capture::Capture> capture;
+    // declared last, so it is unsubscribed before anything it uses goes
+    speech::helpers::CancelCallback cancel;
+
+    void interrupt();
+};
+
+} // namespace stt
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "speech/cancel.hpp"
+#include "speech/stt/interfaces/textfromvoice.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stt
+{
+
+struct sessionconfig_t
+{
+    // audio captured in process, utterances cut by voice activity detection
+    std::shared_ptr<capture::SourceIf> source;
+    std::optional<capture::vadconfig_t> vad{capture::vadconfig_t{}};
+    std::chrono::milliseconds maxutterance{std::chrono::seconds{15}};
+    language lang{language::polish};
+    // utterances captured but not yet recognized, and recognized ones
+    // waiting for earlier to be delivered; when either is full source that
+    // is not realtime is paused, utterance of realtime one is dropped
+    size_t queuesize{4};
+    // recognitions in flight at once
+    size_t concurrency{2};
+    // failed recognition is retried, and failed realtime source reopened,
+    // after delay doubled each time up to limit
+    size_t retries{3};
+    std::chrono::milliseconds backoff{200};
+    std::chrono::milliseconds maxbackoff{std::chrono::seconds{5}};
+};
+
+// one utterance, delivered in order of capture
+struct sessionresult_t
+{
+    uint64_t utterance;
+    std::optional<transcript_t> transcript;
+    // reason of last failed attempt, empty when backend answered
+    std::string error;
+    // from end of capture until delivery
+    std::chrono::milliseconds latency;
+};
+
+// [utterances now in stage, most ever at once, mean and worst time spent]
+struct stagestats_t
+{
+    size_t depth;
+    size_t peak;
+    std::chrono::milliseconds mean;
+    std::chrono::milliseconds max;
+};
+
+struct sessionstats_t
+{
+    uint64_t utterances;
+    uint64_t transcripts;
+    uint64_t failed;
+    uint64_t retries;
+    // source could not be opened or stopped delivering audio
+    uint64_t sourcefailures;
+    // utterances of realtime source dropped as later stages were full
+    uint64_t dropped;
+    // callback threw, delivery went on with next result
+    uint64_t callbackfailures;
+    // time source was paused as later stages were full
+    std::chrono::milliseconds stalled;
+    stagestats_t queue;
+    stagestats_t recognition;
+    stagestats_t delivery;
+};
+
+// continuous listening, next utterance is captured while earlier ones are
+// still recognized; source is opened once and read by one producer for
+// whole session, its endpointer cuts utterances, so no audio is lost
+// between them; recognitions run concurrently on given backend under token
+// of session, so stop cancels them and no other calls of backend
+class ListenSession
+{
+  public:
+    using callback_t = std::function<void(const sessionresult_t&)>;
+
+    ListenSession(std::shared_ptr<TextFromVoiceIf>, const sessionconfig_t&,
+                  callback_t);
+    ~ListenSession();
+    ListenSession(const ListenSession&) = delete;
+    ListenSession(ListenSession&&) = delete;
+    ListenSession& operator=(const ListenSession&) = delete;
+    ListenSession& operator=(ListenSession&&) = delete;
+
+    // false when already running
+    bool start();
+    // source that is not realtime ends session once exhausted, this waits
+    // until all its utterances are delivered; false when session was
+    // stopped first, realtime source is only ended by stop
+    bool wait();
+    // utterance being captured and queued ones are dropped, recognitions in
+    // flight are cancelled; callback is not called once it returns, so it
+    // must not be called from callback; also releases session that ended
+    // by itself
+    void stop();
+    sessionstats_t getstats() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct Utterance
+    {
+        uint64_t index;
+        std::vector<int16_t> samples;
+        clock::time_point captured;
+    };
+    struct Result
+    {
+        sessionresult_t result;
+        clock::time_point captured;
+        clock::time_point recognized;
+    };
+    struct Stage
+    {
+        size_t depth;
+        size_t peak;
+        uint64_t count;
+        clock::duration total;
+        clock::duration max;
+    };
+
+    const std::shared_ptr<TextFromVoiceIf> stt;
+    const sessionconfig_t config;
+    const callback_t callback;
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    bool running{false};
+    // capture ended, so nothing more is queued, and all delivered
+    bool exhausted{false};
+    bool finished{false};
+    std::deque<Utterance> utterances;
+    // recognized out of order, kept until earlier ones are delivered
+    std::map<uint64_t, Result> results;
+    uint64_t captured{};
+    uint64_t delivered{};
+    sessionstats_t stats{};
+    Stage queue{}, recognition{}, delivery{};
+    std::shared_ptr<speech::helpers::CancelToken> token;
+    std::thread capturer;
+    std::vector<std::thread> recognizers;
+    std::thread deliverer;
+
+    void capture();
+    void exhaust();
+    bool push(std::vector<int16_t>&&);
+    bool isrunning() const;
+    void recognize();
+    void deliver();
+    sessionresult_t transcribe(const Utterance&);
+    bool backoff(std::chrono::milliseconds&);
+    static void enter(Stage&);
+    static void leave(Stage&, clock::duration);
+    static stagestats_t getstats(const Stage&);
+};
+
+} // namespace stt
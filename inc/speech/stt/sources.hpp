@@ -0,0 +1,44 @@
+#pragma once
+
+#include "speech/stt/capture.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace stt::capture
+{
+
+class AlsaSource : public SourceIf
+{
+  public:
+    explicit AlsaSource(const std::string& = "default");
+    ~AlsaSource();
+    bool open() override;
+    size_t read(std::span<int16_t>) override;
+    void close() override;
+    bool isrealtime() const override;
+
+  private:
+    struct Handler;
+    std::shared_ptr<Handler> handler;
+};
+
+// replays wav (linear16) or flac file, for running without sound hardware,
+// audio is converted to mono and resampled when needed, realtime mode paces
+// reading as microphone would
+class FileSource : public SourceIf
+{
+  public:
+    explicit FileSource(const std::filesystem::path&, bool = false);
+    ~FileSource();
+    bool open() override;
+    size_t read(std::span<int16_t>) override;
+    void close() override;
+    bool isrealtime() const override;
+
+  private:
+    struct Handler;
+    std::shared_ptr<Handler> handler;
+};
+
+} // namespace stt::capture
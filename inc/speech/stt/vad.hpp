@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace stt::capture
+{
+
+// sum of squared samples, vectorized where cpu allows
+uint64_t getenergy(std::span<const int16_t>);
+// number of sign changes between neighbouring samples
+uint32_t getzerocrossings(std::span<const int16_t>);
+// portable implementations, used for input tail and as fallback
+uint64_t getenergyscalar(std::span<const int16_t>);
+uint32_t getzerocrossingsscalar(std::span<const int16_t>);
+
+// shorter trailing silence ends utterance sooner, but may cut it at pause
+enum class endpointing
+{
+    fast,
+    balanced,
+    accurate
+};
+
+struct vadconfig_t
+{
+    // audio kept from before speech onset, so first syllable is not lost
+    std::chrono::milliseconds preroll{300};
+    // continuous speech needed to start utterance, shorter clicks ignored
+    std::chrono::milliseconds onset{60};
+    // continuous silence needed to end utterance
+    std::chrono::milliseconds trailing{600};
+    // frame is speech when its energy exceeds noise floor that many times
+    double threshold{4.0};
+    // noise floor follows rising level that slowly, falling one at once
+    double adaptation{0.02};
+};
+
+vadconfig_t getvadconfig(endpointing);
+
+enum class vadevent
+{
+    none,
+    started,
+    ended
+};
+
+// finds utterance in continuous audio by frame energy and zero crossings
+// compared to adaptive estimate of background noise
+class Endpointer
+{
+  public:
+    explicit Endpointer(const vadconfig_t& = {});
+
+    // samples belonging to utterance are appended to output, preroll
+    // included, nothing is appended once utterance ended until reset
+    vadevent process(std::span<const int16_t>, std::vector<int16_t>&);
+    void reset();
+    bool isspeaking() const;
+    // mean energy per sample of background noise
+    double getnoisefloor() const;
+
+  private:
+    enum class state
+    {
+        silence,
+        speech,
+        ended
+    };
+
+    const vadconfig_t config;
+    const size_t onsetframes;
+    const size_t trailingframes;
+    const size_t prerollsize;
+    state current{state::silence};
+    std::vector<int16_t> frame;
+    std::deque<int16_t> preroll;
+    size_t speechframes{};
+    size_t silentframes{};
+    double noisefloor{};
+
+    vadevent processframe(std::vector<int16_t>&);
+    bool isspeech(double, uint32_t) const;
+};
+
+} // namespace stt::capture
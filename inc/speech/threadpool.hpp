@@ -0,0 +1,134 @@
+#pragma once
+
+#include "speech/cancel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace speech::helpers
+{
+
+struct GroupState;
+
+// [tasks run, tasks taken from queue of other worker, tasks dropped by
+// cancellation, tasks run by submitter as their group was full]
+struct poolstats_t
+{
+    uint64_t executed;
+    uint64_t stolen;
+    uint64_t cancelled;
+    uint64_t inlined;
+};
+
+// fixed set of workers, each with own queue, idle workers steal from busy
+// ones, task submitted from worker goes to its own queue to stay cache warm
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(size_t);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    size_t getworkers() const;
+    poolstats_t getstats() const;
+
+    static std::shared_ptr<ThreadPool> getdefault();
+
+  private:
+    friend class TaskGroup;
+    struct Task
+    {
+        std::function<void()> func;
+        std::shared_ptr<GroupState> group;
+        uint64_t generation;
+    };
+    struct Queue
+    {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t pending{};
+    bool running{true};
+    std::atomic<size_t> next{};
+    std::atomic<uint64_t> executed{}, stolen{}, cancelled{}, inlined{};
+
+    void push(Task&&);
+    bool pop(size_t, Task&);
+    void run(size_t);
+    void execute(Task&);
+};
+
+// tasks of one owner on shared pool, owner waits for and cancels only its
+// own tasks and never has more than given number of them queued or running
+class TaskGroup
+{
+  public:
+    TaskGroup(std::shared_ptr<ThreadPool>, size_t);
+    ~TaskGroup();
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+    // false when group is full, task is then not taken
+    bool submit(std::function<void()>&&);
+    // task is run by caller when group is full, so result always comes
+    template <typename F>
+    std::future<std::invoke_result_t<F>> async(F&& func)
+    {
+        using result_t = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<result_t()>>(
+            std::forward<F>(func));
+        auto result = task->get_future();
+        if (!submit([task]() { (*task)(); }))
+        {
+            pool->inlined++;
+            (*task)();
+        }
+        return result;
+    }
+    // task of cancellable caller waits for free slot instead, as caller
+    // running it could not be let go on cancel; task is dropped when token
+    // is cancelled meanwhile
+    template <typename F>
+    std::future<std::invoke_result_t<F>> async(F&& func,
+                                               const CancelToken& token)
+    {
+        using result_t = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<result_t()>>(
+            std::forward<F>(func));
+        auto result = task->get_future();
+        while (!submit([task]() { (*task)(); }) && !token.iscancelled())
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        return result;
+    }
+    // returns whether there was anything to wait for
+    bool wait();
+    // queued tasks are dropped, running ones are let finish
+    bool cancel();
+    size_t getpending() const;
+
+  private:
+    const std::shared_ptr<ThreadPool> pool;
+    const size_t capacity;
+    const std::shared_ptr<GroupState> state;
+};
+
+} // namespace speech::helpers
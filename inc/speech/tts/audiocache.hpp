@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace tts
+{
+
+// [text, resolved voice, audio encoding]
+using audiokey_t = std::tuple<std::string, std::string, std::string>;
+using audio_t = std::shared_ptr<const std::string>;
+
+// normalized text, voice and encoding joined into single lookup key
+std::string getcachekey(const audiokey_t&);
+
+struct cachestats_t
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+};
+
+class AudioCache
+{
+  public:
+    explicit AudioCache(size_t);
+    AudioCache(const AudioCache&) = delete;
+    AudioCache(AudioCache&&) = delete;
+    AudioCache& operator=(const AudioCache&) = delete;
+    AudioCache& operator=(AudioCache&&) = delete;
+
+    audio_t get(const audiokey_t&);
+    audio_t put(const audiokey_t&, std::string&&);
+    cachestats_t getstats() const;
+
+  private:
+    using entry_t = std::pair<std::string, audio_t>;
+
+    const size_t budget;
+    mutable std::mutex mtx;
+    std::list<entry_t> entries;
+    std::unordered_map<std::string, std::list<entry_t>::iterator> index;
+    cachestats_t stats{};
+
+    void evict(size_t);
+};
+
+} // namespace tts
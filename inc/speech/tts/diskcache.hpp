@@ -0,0 +1,51 @@
+#pragma once
+
+#include "speech/tts/audiocache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+namespace tts
+{
+
+class DiskCache
+{
+  public:
+    DiskCache(const std::filesystem::path&, uint64_t);
+    ~DiskCache();
+    DiskCache(const DiskCache&) = delete;
+    DiskCache(DiskCache&&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+    DiskCache& operator=(DiskCache&&) = delete;
+
+    std::optional<std::filesystem::path> get(const audiokey_t&);
+    std::optional<std::filesystem::path> put(const audiokey_t&,
+                                             std::string_view);
+    std::optional<std::filesystem::path> putfile(const audiokey_t&,
+                                                 const std::filesystem::path&);
+    cachestats_t getstats() const;
+
+  private:
+    const std::filesystem::path directory;
+    const uint64_t budget;
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    cachestats_t stats{};
+    bool evictneeded{true};
+    bool running{true};
+    std::thread evictor;
+
+    std::filesystem::path getpath(const audiokey_t&) const;
+    std::filesystem::path gettemppath(const std::filesystem::path&) const;
+    std::optional<std::filesystem::path> commit(const std::filesystem::path&,
+                                                const std::filesystem::path&);
+    void runevictor();
+    void evict();
+};
+
+} // namespace tts
@@ -15,7 +15,10 @@ using configmin_t = std::tuple<voice_t, std::shared_ptr<logs::LogIf>>;
 using configall_t = std::tuple<voice_t, std::shared_ptr<shell::ShellIf>,
                                std::shared_ptr<speech::helpers::HelpersIf>,
                                std::shared_ptr<logs::LogIf>>;
-using config_t = std::variant<std::monostate, configmin_t, configall_t>;
+using configext_t =
+    std::tuple<voice_t, options_t, std::shared_ptr<logs::LogIf>>;
+using config_t =
+    std::variant<std::monostate, configmin_t, configall_t, configext_t>;
 
 class TextToVoice : public TextToVoiceIf
 {
@@ -23,11 +26,16 @@ class TextToVoice : public TextToVoiceIf
     ~TextToVoice();
     bool speak(const std::string&) override;
     bool speak(const std::string&, const voice_t&) override;
+    speakhandle_t enqueue(const std::string&) override;
+    speakhandle_t enqueue(const std::string&, const voice_t&) override;
     bool speakasync(const std::string&) override;
     bool speakasync(const std::string&, const voice_t&) override;
     bool waitspoken() override;
+    audio_t synthesize(const std::string&) override;
+    audio_t synthesize(const std::string&, const voice_t&) override;
     voice_t getvoice() override;
     void setvoice(const voice_t&) override;
+    bool cancel() override;
 
   private:
     friend class tts::TextToVoiceFactory;
@@ -5,6 +5,8 @@
 #include "speech/helpers.hpp"
 #include "speech/tts/factory.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <tuple>
 #include <variant>
 
@@ -15,7 +17,21 @@ using configmin_t = std::tuple<voice_t, std::shared_ptr<logs::LogIf>>;
 using configall_t = std::tuple<voice_t, std::shared_ptr<shell::ShellIf>,
                                std::shared_ptr<speech::helpers::HelpersIf>,
                                std::shared_ptr<logs::LogIf>>;
-using config_t = std::variant<std::monostate, configmin_t, configall_t>;
+using configext_t =
+    std::tuple<voice_t, options_t, std::shared_ptr<logs::LogIf>>;
+using config_t =
+    std::variant<std::monostate, configmin_t, configall_t, configext_t>;
+
+// [utterances streamed, times player ran out of audio while stream went
+// on, total time it waited, mean and worst time to first audio]
+struct streamstats_t
+{
+    uint64_t streams;
+    uint64_t underruns;
+    std::chrono::milliseconds starved;
+    std::chrono::milliseconds firstaudio;
+    std::chrono::milliseconds firstaudiomax;
+};
 
 class TextToVoice : public TextToVoiceIf
 {
@@ -23,11 +39,17 @@ class TextToVoice : public TextToVoiceIf
     ~TextToVoice();
     bool speak(const std::string&) override;
     bool speak(const std::string&, const voice_t&) override;
+    speakhandle_t enqueue(const std::string&) override;
+    speakhandle_t enqueue(const std::string&, const voice_t&) override;
     bool speakasync(const std::string&) override;
     bool speakasync(const std::string&, const voice_t&) override;
     bool waitspoken() override;
+    audio_t synthesize(const std::string&) override;
+    audio_t synthesize(const std::string&, const voice_t&) override;
     voice_t getvoice() override;
     void setvoice(const voice_t&) override;
+    bool cancel() override;
+    streamstats_t getstreamstats() const;
 
   private:
     friend class tts::TextToVoiceFactory;
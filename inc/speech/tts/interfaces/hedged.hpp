@@ -0,0 +1,85 @@
+#pragma once
+
+#include "logs/interfaces/logs.hpp"
+#include "speech/tts/factory.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+namespace tts::hedged
+{
+
+using backends_t = std::vector<std::shared_ptr<TextToVoiceIf>>;
+
+// attempt i goes to backend i modulo their number, so single backend is
+// hedged against itself; next attempt starts once delay passes with no
+// audio yet, or at once when all running ones failed, 0 races all of them
+struct hedgeconfig_t
+{
+    std::chrono::milliseconds delay{300};
+    size_t attempts{2};
+};
+
+// latency of successful attempts, also of those that lost the race
+struct backendstats_t
+{
+    uint64_t requests;
+    uint64_t hedges;
+    uint64_t wins;
+    uint64_t failures;
+    uint64_t cancelled;
+    std::chrono::milliseconds p50;
+    std::chrono::milliseconds p99;
+};
+
+struct hedgestats_t
+{
+    uint64_t syntheses;
+    uint64_t hedged;
+    uint64_t hedgewins;
+    // share of syntheses that needed hedge, share of hedges that won
+    double hedgerate;
+    double hedgewinrate;
+    std::vector<backendstats_t> backends;
+};
+
+using configmin_t =
+    std::tuple<backends_t, hedgeconfig_t, std::shared_ptr<logs::LogIf>>;
+using configext_t = std::tuple<backends_t, hedgeconfig_t, options_t,
+                               std::shared_ptr<logs::LogIf>>;
+using config_t = std::variant<std::monostate, configmin_t, configext_t>;
+
+// composite of other backends, audio of first attempt to succeed is used
+// and ones still running are cancelled; only queue, policy, synthesize
+// ahead, player and timeout are taken from options, caching is left to
+// backends
+class TextToVoice : public TextToVoiceIf
+{
+  public:
+    ~TextToVoice();
+    bool speak(const std::string&) override;
+    bool speak(const std::string&, const voice_t&) override;
+    speakhandle_t enqueue(const std::string&) override;
+    speakhandle_t enqueue(const std::string&, const voice_t&) override;
+    bool speakasync(const std::string&) override;
+    bool speakasync(const std::string&, const voice_t&) override;
+    bool waitspoken() override;
+    audio_t synthesize(const std::string&) override;
+    audio_t synthesize(const std::string&, const voice_t&) override;
+    voice_t getvoice() override;
+    void setvoice(const voice_t&) override;
+    bool cancel() override;
+    hedgestats_t getstats() const;
+
+  private:
+    friend class tts::TextToVoiceFactory;
+    TextToVoice(const config_t&);
+
+    struct Handler;
+    std::shared_ptr<Handler> handler;
+};
+
+} // namespace tts::hedged
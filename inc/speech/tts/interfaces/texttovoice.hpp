@@ -1,6 +1,14 @@
 #pragma once
 
+#include "speech/connections.hpp"
+#include "speech/tts/audiocache.hpp"
+#include "speech/tts/diskcache.hpp"
+#include "speech/tts/playback.hpp"
+#include "speech/tts/speakqueue.hpp"
+
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 
@@ -23,17 +31,57 @@ enum class gender
 using index = uint8_t;
 using voice_t = std::tuple<language, gender, index>;
 
+struct options_t
+{
+    // synthesized audio reused by all instances given same cache
+    std::shared_ptr<AudioCache> cache;
+    // audio files kept between runs, played directly from cache directory
+    std::shared_ptr<DiskCache> diskcache;
+    // utterances waiting for playback and what to do when there is no room
+    size_t queuesize{8};
+    queuepolicy policy{queuepolicy::block};
+    // sentences synthesized ahead of one being played, 0 speaks text at once
+    size_t synthesizeahead{0};
+    // audio played in process, own player on default sound device is made
+    // when not given
+    std::shared_ptr<playback::Player> player;
+    // fallback for hosts where sound device cannot be used in process, every
+    // segment is written to file and played by spawned external player
+    bool externalplayer{false};
+    // googlecloud only, connection is shared by instances of same config
+    speech::helpers::connconfig_t connection;
+    // synthesis request not done in time is aborted, 0 waits for it
+    std::chrono::milliseconds timeout{0};
+    // googlecloud only, audio is passed to player while still synthesized,
+    // caches are bypassed; voices are chosen among ones streaming supports
+    bool streaming{false};
+};
+
+// player given in options or own in-process one, none when external
+// player was asked for
+std::shared_ptr<playback::Player> getplayer(const options_t&);
+
 class TextToVoiceIf
 {
   public:
     virtual ~TextToVoiceIf() = default;
     virtual bool speak(const std::string&) = 0;
     virtual bool speak(const std::string&, const voice_t&) = 0;
+    virtual speakhandle_t enqueue(const std::string&) = 0;
+    virtual speakhandle_t enqueue(const std::string&, const voice_t&) = 0;
     virtual bool speakasync(const std::string&) = 0;
     virtual bool speakasync(const std::string&, const voice_t&) = 0;
     virtual bool waitspoken() = 0;
+    // audio is returned instead of played, calls may run in parallel
+    virtual audio_t synthesize(const std::string&) = 0;
+    virtual audio_t synthesize(const std::string&, const voice_t&) = 0;
     virtual voice_t getvoice() = 0;
     virtual void setvoice(const voice_t&) = 0;
+    // barge-in: playback of this instance stops at once, queued utterances
+    // are dropped and syntheses in flight are abandoned; returns whether
+    // anything was queued or spoken
+    virtual bool cancel() = 0;
+    // kills every external player on host, cancel() stops only own one
     static void kill();
 };
 
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "logs/interfaces/logs.hpp"
+#include "shell/interfaces/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/threadpool.hpp"
+#include "speech/tts/audiocache.hpp"
+#include "speech/tts/playback.hpp"
+#include "speech/tts/speakqueue.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <source_location>
+#include <string>
+
+namespace tts
+{
+
+// audio of one segment of text, played from memory when given, otherwise
+// from file
+struct segment_t
+{
+    std::string file;
+    audio_t audio;
+};
+
+// plays text of one utterance for backends, which only start synthesis of
+// its segments; with synthesize ahead text is played sentence by sentence,
+// first one as soon as it is ready while following are synthesized
+// meanwhile, otherwise as whole
+class Pipeline
+{
+  public:
+    using synthesis_t = std::future<segment_t>;
+    // starts synthesis of text of segment of given index
+    using synthesizer_t =
+        std::function<synthesis_t(const std::string&, size_t)>;
+
+    Pipeline(std::shared_ptr<logs::LogIf>, std::shared_ptr<shell::ShellIf>,
+             std::shared_ptr<playback::Player>, size_t);
+    Pipeline(const Pipeline&) = delete;
+    Pipeline(Pipeline&&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    Pipeline& operator=(Pipeline&&) = delete;
+
+    spoken_t play(const std::string&, const synthesizer_t&,
+                  const std::shared_ptr<speech::helpers::CancelToken>&);
+    // blocking synthesis run on pool, one for segment being played and
+    // each synthesized ahead
+    synthesis_t async(std::function<segment_t()>&&);
+    // syntheses not yet started are dropped, ones running are abandoned
+    // by their tokens
+    bool cancel();
+
+    // false only when utterance was refused at once by queue
+    static bool isaccepted(const speakhandle_t&);
+
+  private:
+    const std::shared_ptr<logs::LogIf> logif;
+    const std::shared_ptr<shell::ShellIf> shell;
+    // none only when external player was asked for as fallback
+    const std::shared_ptr<playback::Player> player;
+    const size_t ahead;
+    // syntheses own copies of their arguments, as pool futures do not wait
+    // for task when dropped
+    speech::helpers::TaskGroup tasks;
+
+    bool playsegment(const segment_t&,
+                     const std::shared_ptr<speech::helpers::CancelToken>&);
+    bool playfile(const std::string&,
+                  const std::shared_ptr<speech::helpers::CancelToken>&);
+    bool playaudio(const std::string&,
+                   const std::shared_ptr<speech::helpers::CancelToken>&);
+    void log(logs::level, const std::string&,
+             const std::source_location =
+                 std::source_location::current()) const;
+};
+
+} // namespace tts
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "speech/cancel.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+
+namespace tts::playback
+{
+
+// interleaved signed 16-bit little endian samples
+struct format_t
+{
+    uint32_t rate;
+    uint16_t channels;
+    bool operator==(const format_t&) const = default;
+};
+
+class SinkIf
+{
+  public:
+    virtual ~SinkIf() = default;
+    // kept open between calls, reopened only when format changes
+    virtual bool open(const format_t&) = 0;
+    virtual bool write(std::span<const int16_t>) = 0;
+    // blocks until everything written was played
+    virtual bool drain() = 0;
+    // called from other thread, audio not yet played is discarded and
+    // blocked write or drain returns at once; sink is usable again after
+    // next open or drain
+    virtual bool stop() = 0;
+};
+
+// decodes mp3 or wav (linear16) audio in process and streams it to sink,
+// audio is written in short pieces so play given token stops within one of
+// them once token is cancelled
+class Player
+{
+  public:
+    explicit Player(std::shared_ptr<SinkIf>);
+    Player(const Player&) = delete;
+    Player(Player&&) = delete;
+    Player& operator=(const Player&) = delete;
+    Player& operator=(Player&&) = delete;
+
+    bool play(std::string_view,
+              std::shared_ptr<speech::helpers::CancelToken> = nullptr);
+    bool play(const std::filesystem::path&,
+              std::shared_ptr<speech::helpers::CancelToken> = nullptr);
+    // raw samples, as received piece by piece from streaming synthesis
+    bool play(std::span<const int16_t>, const format_t&,
+              std::shared_ptr<speech::helpers::CancelToken> = nullptr);
+    bool drain(std::shared_ptr<speech::helpers::CancelToken> = nullptr);
+
+  private:
+    const std::shared_ptr<SinkIf> sink;
+    std::mutex mtx;
+
+    bool playwav(std::string_view, const speech::helpers::CancelToken*);
+    bool playmp3(std::string_view, const speech::helpers::CancelToken*);
+    bool write(std::span<const int16_t>, const format_t&,
+               const speech::helpers::CancelToken*);
+};
+
+} // namespace tts::playback
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "speech/tts/playback.hpp"
+
+#include <atomic>
+#include <string>
+
+namespace tts::playback
+{
+
+class AlsaSink : public SinkIf
+{
+  public:
+    explicit AlsaSink(const std::string& = "default");
+    ~AlsaSink();
+    bool open(const format_t&) override;
+    bool write(std::span<const int16_t>) override;
+    bool drain() override;
+    bool stop() override;
+
+  private:
+    struct Handler;
+    std::shared_ptr<Handler> handler;
+};
+
+// discards audio, for running without sound hardware
+class NullSink : public SinkIf
+{
+  public:
+    bool open(const format_t&) override;
+    bool write(std::span<const int16_t>) override;
+    bool drain() override;
+    bool stop() override;
+    uint64_t getsamples() const;
+
+  private:
+    std::atomic<uint64_t> samples{};
+};
+
+// collects audio of all utterances in single wav file, all of them of
+// format of first one, audio of other format is refused
+class WavSink : public SinkIf
+{
+  public:
+    explicit WavSink(const std::filesystem::path&);
+    ~WavSink();
+    bool open(const format_t&) override;
+    bool write(std::span<const int16_t>) override;
+    bool drain() override;
+    bool stop() override;
+
+  private:
+    struct Handler;
+    std::shared_ptr<Handler> handler;
+};
+
+} // namespace tts::playback
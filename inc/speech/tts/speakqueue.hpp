@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace tts
+{
+
+// what to do with new utterance when queue is full
+enum class queuepolicy
+{
+    block,
+    dropoldest,
+    reject
+};
+
+// outcome of one utterance, time to first audio is taken from start of
+// its playback until first of its audio was passed to be played
+struct spoken_t
+{
+    bool spoken;
+    std::optional<std::chrono::milliseconds> firstaudio;
+    size_t segments;
+
+    explicit operator bool() const
+    {
+        return spoken;
+    }
+};
+
+using speakhandle_t = std::shared_future<spoken_t>;
+
+struct queuestats_t
+{
+    uint64_t queued;
+    uint64_t spoken;
+    uint64_t dropped;
+    uint64_t rejected;
+    uint64_t cancelled;
+};
+
+class SpeakQueue
+{
+  public:
+    using job_t = std::function<spoken_t()>;
+
+    SpeakQueue(size_t, queuepolicy);
+    ~SpeakQueue();
+    SpeakQueue(const SpeakQueue&) = delete;
+    SpeakQueue(SpeakQueue&&) = delete;
+    SpeakQueue& operator=(const SpeakQueue&) = delete;
+    SpeakQueue& operator=(SpeakQueue&&) = delete;
+
+    speakhandle_t push(job_t&&);
+    // returns whether there was anything to wait for
+    bool wait();
+    // queued utterances are dropped, one being spoken is left to its owner
+    // to interrupt; returns whether there was anything queued or spoken
+    bool cancel();
+    size_t pending() const;
+    queuestats_t getstats() const;
+
+  private:
+    struct Utterance
+    {
+        job_t job;
+        std::promise<spoken_t> done;
+    };
+
+    const size_t capacity;
+    const queuepolicy policy;
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Utterance> utterances;
+    queuestats_t stats{};
+    bool speaking{false};
+    bool running{true};
+    std::thread worker;
+
+    void run();
+};
+
+} // namespace tts
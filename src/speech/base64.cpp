@@ -0,0 +1,265 @@
+#include "speech/base64.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace speech::helpers::base64
+{
+
+static constexpr uint8_t invalidSign{0xff};
+static constexpr auto decodeMap = []() {
+    std::array<uint8_t, 256> map{};
+    map.fill(invalidSign);
+    constexpr std::string_view alphabet{
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+    for (uint8_t value{}; value < alphabet.size(); value++)
+        map[(uint8_t)alphabet[value]] = value;
+    return map;
+}();
+
+// vectorized loops return number of input bytes consumed, they stop at
+// first block with padding or invalid sign and leave rest to scalar code
+using decodeblocks_t = size_t (*)(std::string_view, uint8_t*, size_t);
+
+// sign to value translation by nibble lookups and 4x6 bits to 3 bytes
+// packing by multiply-add, as described by W. Mula and D. Lemire
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static size_t
+    decodeavx2(std::string_view input, uint8_t* output, size_t outsize)
+{
+    const __m256i lutlo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+        0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i luthi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+        0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutroll =
+        _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0,
+                         0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0,
+                         0, 0, 0, 0);
+    const __m256i mask2f = _mm256_set1_epi8(0x2f);
+    const __m256i shuffle = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6,
+        5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t consumed{}, produced{};
+    // each store writes 32 bytes of which 24 are valid
+    for (; consumed + 32 <= input.size() && produced + 32 <= outsize;
+         consumed += 32, produced += 24)
+    {
+        auto data =
+            _mm256_loadu_si256((const __m256i*)(input.data() + consumed));
+        auto hinibbles = _mm256_and_si256(_mm256_srli_epi32(data, 4), mask2f);
+        auto lonibbles = _mm256_and_si256(data, mask2f);
+        auto hi = _mm256_shuffle_epi8(luthi, hinibbles);
+        auto lo = _mm256_shuffle_epi8(lutlo, lonibbles);
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+        auto eq2f = _mm256_cmpeq_epi8(data, mask2f);
+        auto roll =
+            _mm256_shuffle_epi8(lutroll, _mm256_add_epi8(eq2f, hinibbles));
+        data = _mm256_add_epi8(data, roll);
+        data = _mm256_maddubs_epi16(data, _mm256_set1_epi32(0x01400140));
+        data = _mm256_madd_epi16(data, _mm256_set1_epi32(0x00011000));
+        data = _mm256_shuffle_epi8(data, shuffle);
+        data = _mm256_permutevar8x32_epi32(data, permute);
+        _mm256_storeu_si256((__m256i*)(output + produced), data);
+    }
+    return consumed;
+}
+
+__attribute__((target("ssse3"))) static size_t
+    decodessse3(std::string_view input, uint8_t* output, size_t outsize)
+{
+    const __m128i lutlo =
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                      0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i luthi =
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutroll =
+        _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2f = _mm_set1_epi8(0x2f);
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+                                          12, -1, -1, -1, -1);
+
+    size_t consumed{}, produced{};
+    // each store writes 16 bytes of which 12 are valid
+    for (; consumed + 16 <= input.size() && produced + 16 <= outsize;
+         consumed += 16, produced += 12)
+    {
+        auto data = _mm_loadu_si128((const __m128i*)(input.data() + consumed));
+        auto hinibbles = _mm_and_si128(_mm_srli_epi32(data, 4), mask2f);
+        auto lonibbles = _mm_and_si128(data, mask2f);
+        auto hi = _mm_shuffle_epi8(luthi, hinibbles);
+        auto lo = _mm_shuffle_epi8(lutlo, lonibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                             _mm_setzero_si128())) != 0)
+            break;
+        auto eq2f = _mm_cmpeq_epi8(data, mask2f);
+        auto roll = _mm_shuffle_epi8(lutroll, _mm_add_epi8(eq2f, hinibbles));
+        data = _mm_add_epi8(data, roll);
+        data = _mm_maddubs_epi16(data, _mm_set1_epi32(0x01400140));
+        data = _mm_madd_epi16(data, _mm_set1_epi32(0x00011000));
+        data = _mm_shuffle_epi8(data, shuffle);
+        _mm_storeu_si128((__m128i*)(output + produced), data);
+    }
+    return consumed;
+}
+
+static decodeblocks_t getdecodeblocks()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return decodeavx2;
+    if (__builtin_cpu_supports("ssse3"))
+        return decodessse3;
+    return nullptr;
+}
+#elif defined(__aarch64__)
+static size_t decodeneon(std::string_view input, uint8_t* output, size_t)
+{
+    const uint8x16_t lutlo = {0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A};
+    const uint8x16_t luthi = {0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10};
+    const uint8x16_t lutroll = {0,   16,  19,  4,   191, 191, 185, 185,
+                                0,   0,   0,   0,   0,   0,   0,   0};
+    const uint8x16_t mask2f = vdupq_n_u8(0x2f);
+    const uint8x16_t masklo = vdupq_n_u8(0x0f);
+
+    auto translate = [&](uint8x16_t data, bool& valid) {
+        auto hinibbles = vshrq_n_u8(data, 4);
+        auto hi = vqtbl1q_u8(luthi, hinibbles);
+        auto lo = vqtbl1q_u8(lutlo, vandq_u8(data, masklo));
+        valid = valid && vmaxvq_u8(vandq_u8(lo, hi)) == 0;
+        auto eq2f = vceqq_u8(data, mask2f);
+        return vaddq_u8(data,
+                        vqtbl1q_u8(lutroll, vaddq_u8(eq2f, hinibbles)));
+    };
+
+    // 64 signs are deinterleaved into 4 vectors and 48 bytes stored exactly
+    size_t consumed{}, produced{};
+    for (; consumed + 64 <= input.size(); consumed += 64, produced += 48)
+    {
+        auto data = vld4q_u8((const uint8_t*)input.data() + consumed);
+        bool valid{true};
+        auto a = translate(data.val[0], valid);
+        auto b = translate(data.val[1], valid);
+        auto c = translate(data.val[2], valid);
+        auto d = translate(data.val[3], valid);
+        if (!valid)
+            break;
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(output + produced, bytes);
+    }
+    return consumed;
+}
+
+static decodeblocks_t getdecodeblocks()
+{
+    return decodeneon;
+}
+#else
+static decodeblocks_t getdecodeblocks()
+{
+    return nullptr;
+}
+#endif
+
+size_t getdecodedsize(std::string_view input)
+{
+    size_t padding{};
+    for (; padding < 2 && padding < input.size() &&
+           input[input.size() - 1 - padding] == '=';
+         padding++)
+        ;
+    auto signs = input.size() - padding;
+    return signs / 4 * 3 + (signs % 4 * 3) / 4;
+}
+
+bool decodescalar(std::string_view input, std::span<char> output)
+{
+    if (output.size() != getdecodedsize(input))
+        return false;
+    while (!input.empty() && input.back() == '=')
+        input.remove_suffix(1);
+    if (input.size() % 4 == 1)
+        return false;
+
+    auto out = (uint8_t*)output.data();
+    uint32_t accumulator{};
+    size_t bits{};
+    for (auto sign : input)
+    {
+        auto value = decodeMap[(uint8_t)sign];
+        if (value == invalidSign)
+            return false;
+        accumulator = (accumulator << 6) | value;
+        if ((bits += 6) >= 8)
+        {
+            bits -= 8;
+            *out++ = (uint8_t)(accumulator >> bits);
+        }
+    }
+    return true;
+}
+
+bool decode(std::string_view input, std::span<char> output)
+{
+    static const auto decodeblocks = getdecodeblocks();
+    if (output.size() != getdecodedsize(input))
+        return false;
+
+    size_t consumed{};
+    if (decodeblocks != nullptr)
+        consumed =
+            decodeblocks(input, (uint8_t*)output.data(), output.size());
+    return decodescalar(input.substr(consumed),
+                        output.subspan(consumed / 4 * 3));
+}
+
+static bool decodeappend(std::string_view input, std::string& output)
+{
+    auto offset = output.size();
+    output.resize(offset + getdecodedsize(input));
+    return decode(input, std::span<char>{output}.subspan(offset));
+}
+
+bool StreamDecoder::decode(std::string_view input, std::string& output)
+{
+    if (!pending.empty())
+    {
+        auto missing = std::min(4 - pending.size(), input.size());
+        pending.append(input.substr(0, missing));
+        input.remove_prefix(missing);
+        if (pending.size() < 4)
+            return true;
+        if (!decodeappend(std::exchange(pending, {}), output))
+            return false;
+    }
+    auto whole = input.size() / 4 * 4;
+    pending.assign(input.substr(whole));
+    return decodeappend(input.substr(0, whole), output);
+}
+
+bool StreamDecoder::finish(std::string& output)
+{
+    return decodeappend(std::exchange(pending, {}), output);
+}
+
+} // namespace speech::helpers::base64
@@ -0,0 +1,131 @@
+#include "speech/cancel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace speech::helpers
+{
+
+// token of call running on this thread, set by innermost scope
+static thread_local std::shared_ptr<CancelToken> currentToken;
+
+CancelToken::CancelToken(deadline_t deadline) : deadline{deadline}
+{}
+
+// finished call leaves no callback behind in long-lived parent; cancelled
+// parent drops all of them itself, and may be destroying this token from
+// its callback, so it is not locked again then
+CancelToken::~CancelToken()
+{
+    if (auto token = parent.lock(); token && link && !token->cancelled)
+        token->unsubscribe(link);
+}
+
+// callbacks run under lock, so unsubscribing owner waits for running one
+bool CancelToken::cancel()
+{
+    std::lock_guard lock(mtx);
+    if (cancelled.exchange(true))
+        return false;
+    for (auto& [_, callback] : callbacks)
+        callback();
+    callbacks.clear();
+    return true;
+}
+
+bool CancelToken::iscancelled() const
+{
+    return cancelled ||
+           (deadline && std::chrono::steady_clock::now() >= *deadline);
+}
+
+deadline_t CancelToken::getdeadline() const
+{
+    return deadline;
+}
+
+uint64_t CancelToken::subscribe(std::function<void()>&& callback)
+{
+    {
+        std::lock_guard lock(mtx);
+        if (!cancelled)
+        {
+            callbacks.emplace(++nextid, std::move(callback));
+            return nextid;
+        }
+    }
+    callback();
+    return 0;
+}
+
+void CancelToken::unsubscribe(uint64_t id)
+{
+    std::lock_guard lock(mtx);
+    callbacks.erase(id);
+}
+
+CancelCallback::CancelCallback(std::shared_ptr<CancelToken> token,
+                               std::function<void()>&& callback) :
+    token{token}, id{token ? token->subscribe(std::move(callback)) : 0}
+{}
+
+CancelCallback::~CancelCallback()
+{
+    if (token)
+        token->unsubscribe(id);
+}
+
+std::shared_ptr<CancelToken>
+    Canceller::gettoken(std::chrono::milliseconds timeout)
+{
+    const auto parent = CancelScope::gettoken();
+    deadline_t deadline;
+    if (timeout.count() > 0)
+        deadline = std::chrono::steady_clock::now() + timeout;
+    if (auto outer = parent ? parent->getdeadline() : std::nullopt)
+        deadline = deadline ? std::min(*deadline, *outer) : *outer;
+    auto token = std::make_shared<CancelToken>(deadline);
+    if (parent)
+    {
+        token->parent = parent;
+        token->link = parent->subscribe([weak = std::weak_ptr{token}]() {
+            if (auto token = weak.lock())
+                token->cancel();
+        });
+    }
+    std::lock_guard lock(mtx);
+    // tokens of finished calls are dropped, so list holds calls in flight
+    std::erase_if(tokens, [](const auto& token) { return token.expired(); });
+    tokens.push_back(token);
+    return token;
+}
+
+bool Canceller::cancel()
+{
+    std::vector<std::weak_ptr<CancelToken>> inflight;
+    {
+        std::lock_guard lock(mtx);
+        inflight.swap(tokens);
+    }
+    bool cancelled{false};
+    for (const auto& weak : inflight)
+        if (auto token = weak.lock())
+            cancelled = token->cancel() || cancelled;
+    return cancelled;
+}
+
+CancelScope::CancelScope(std::shared_ptr<CancelToken> token) :
+    previous{std::exchange(currentToken, token)}
+{}
+
+CancelScope::~CancelScope()
+{
+    currentToken = previous;
+}
+
+std::shared_ptr<CancelToken> CancelScope::gettoken()
+{
+    return currentToken;
+}
+
+} // namespace speech::helpers
@@ -0,0 +1,60 @@
+#include "speech/command.hpp"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+
+namespace speech::helpers
+{
+
+static std::filesystem::path getpidfile()
+{
+    static std::atomic<uint64_t> commands{};
+    return std::filesystem::temp_directory_path() /
+           ("speech-" + std::to_string(getpid()) + "-" +
+            std::to_string(commands++) + ".pid");
+}
+
+Command::Command(std::shared_ptr<shell::ShellIf> shell) :
+    shell{shell}, pidfile{getpidfile()},
+    stopfile{pidfile.native() + ".stop"}
+{}
+
+Command::~Command()
+{
+    std::error_code ec;
+    std::filesystem::remove(pidfile, ec);
+    std::filesystem::remove(stopfile, ec);
+}
+
+// shell writes its pid before checking stop mark and only then becomes
+// command, so process is either never started or its pid is seen by kill
+int Command::run(const std::string& cmd)
+{
+    {
+        std::lock_guard lock(mtx);
+        if (killed)
+            return -1;
+    }
+    auto result = shell->run("echo $$ > '" + pidfile.native() + "'; [ -e '" +
+                             stopfile.native() + "' ] || exec " + cmd);
+    std::lock_guard lock(mtx);
+    std::error_code ec;
+    std::filesystem::remove(pidfile, ec);
+    return result;
+}
+
+bool Command::kill()
+{
+    std::lock_guard lock(mtx);
+    killed = true;
+    std::ofstream{stopfile};
+    pid_t pid{};
+    if (std::ifstream ifs{pidfile}; !(ifs >> pid) || pid <= 0)
+        return false;
+    return ::kill(pid, SIGKILL) == 0;
+}
+
+} // namespace speech::helpers
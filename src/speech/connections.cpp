@@ -0,0 +1,51 @@
+#include "speech/connections.hpp"
+
+namespace speech::helpers
+{
+
+static std::string getkey(const std::string& service,
+                          const std::string& location,
+                          const connconfig_t& config)
+{
+    const auto keyfile = std::filesystem::absolute(config.keyfile);
+    return service + "|" + location + "|" + config.endpoint + "|" +
+           keyfile.lexically_normal().native() + "|" +
+           std::to_string(config.channels) + "|" +
+           std::to_string(config.keepalive.count()) + "|" +
+           std::to_string(config.compression);
+}
+
+connstats_t Connections::getstats()
+{
+    std::lock_guard lock(mtx);
+    return stats;
+}
+
+std::shared_ptr<Connections> Connections::getdefault()
+{
+    static const auto connections = std::make_shared<Connections>();
+    return connections;
+}
+
+// created under lock, so concurrent first users still get single connection
+std::shared_ptr<void>
+    Connections::getany(const std::string& service,
+                        const std::string& location,
+                        const connconfig_t& config,
+                        const std::function<std::shared_ptr<void>()>& create)
+{
+    const auto key = getkey(service, location, config);
+    std::lock_guard lock(mtx);
+    if (auto connection = connections.find(key);
+        connection != connections.end())
+    {
+        stats.reused++;
+        return connection->second;
+    }
+    auto connection = create();
+    connections.emplace(key, connection);
+    stats.created++;
+    return connection;
+}
+
+} // namespace speech::helpers
@@ -0,0 +1,112 @@
+#include "speech/curlmulti.hpp"
+
+#include <stdexcept>
+
+namespace speech::helpers
+{
+
+static constexpr int pollTimeoutMs{1000};
+
+CurlMulti::CurlMulti()
+{
+    if ((multi = curl_multi_init()) == nullptr)
+        throw std::runtime_error("Cannot create curl multi handle");
+    engine = std::thread(&CurlMulti::run, this);
+}
+
+CurlMulti::~CurlMulti()
+{
+    running = false;
+    curl_multi_wakeup(multi);
+    engine.join();
+    curl_multi_cleanup(multi);
+}
+
+bool CurlMulti::submit(CurlPool::handle_t&& handle, completion_t&& complete)
+{
+    if (!handle || !running)
+        return false;
+    {
+        std::lock_guard lock(mtx);
+        pending.emplace_back(std::move(handle), std::move(complete));
+        transfers++;
+    }
+    curl_multi_wakeup(multi);
+    return true;
+}
+
+size_t CurlMulti::inflight() const
+{
+    return transfers;
+}
+
+std::shared_ptr<CurlMulti> CurlMulti::getdefault()
+{
+    static const auto multi = std::make_shared<CurlMulti>();
+    return multi;
+}
+
+void CurlMulti::run()
+{
+    while (running)
+    {
+        addpending();
+        int stillrunning{};
+        curl_multi_perform(multi, &stillrunning);
+        collectdone();
+        curl_multi_poll(multi, nullptr, 0, pollTimeoutMs, nullptr);
+    }
+    abortall();
+}
+
+void CurlMulti::addpending()
+{
+    std::vector<Transfer> added;
+    {
+        std::lock_guard lock(mtx);
+        added.swap(pending);
+    }
+    for (auto& transfer : added)
+    {
+        auto curl = transfer.handle.get();
+        if (auto res = curl_multi_add_handle(multi, curl); res != CURLM_OK)
+        {
+            transfer.complete(CURLE_FAILED_INIT);
+            transfers--;
+            continue;
+        }
+        active.emplace(curl, std::move(transfer));
+    }
+}
+
+void CurlMulti::collectdone()
+{
+    int queued{};
+    while (auto msg = curl_multi_info_read(multi, &queued))
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        auto curl = msg->easy_handle;
+        auto result = msg->data.result;
+        curl_multi_remove_handle(multi, curl);
+        if (auto node = active.extract(curl))
+        {
+            node.mapped().complete(result);
+            transfers--;
+        }
+    }
+}
+
+void CurlMulti::abortall()
+{
+    addpending();
+    for (auto& [curl, transfer] : active)
+    {
+        curl_multi_remove_handle(multi, curl);
+        transfer.complete(CURLE_ABORTED_BY_CALLBACK);
+        transfers--;
+    }
+    active.clear();
+}
+
+} // namespace speech::helpers
@@ -0,0 +1,116 @@
+#include "speech/curlpool.hpp"
+
+#include <stdexcept>
+
+namespace speech::helpers
+{
+
+using namespace std::chrono_literals;
+
+static const poolconfig_t defaultPoolConfig = {4, 60s};
+
+CurlPool::CurlPool(const poolconfig_t& config) :
+    maxidle{std::get<size_t>(config)},
+    idletimeout{std::get<std::chrono::seconds>(config)}
+{
+    static std::once_flag globalinit;
+    std::call_once(globalinit, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    if ((share = curl_share_init()) == nullptr)
+        throw std::runtime_error("Cannot create curl share handle");
+    // dns, tls sessions and live connections are shared between all handles
+    // of the pool, so any handle reuses connection left by another one; lock
+    // callbacks serialize access as handles run on many threads
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockshare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockshare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+}
+
+CurlPool::~CurlPool()
+{
+    for (const auto& [curl, _] : idle)
+        curl_easy_cleanup(curl);
+    curl_share_cleanup(share);
+}
+
+CurlPool::handle_t CurlPool::acquire()
+{
+    CURL* curl{};
+    {
+        std::lock_guard lock(mtx);
+        evictidle();
+        if (!idle.empty())
+        {
+            // most recently used handle is taken, so unneeded ones expire
+            curl = idle.back().first;
+            idle.pop_back();
+        }
+    }
+    if (curl == nullptr && (curl = curl_easy_init()) == nullptr)
+        return {nullptr, [](CURL*) {}};
+
+    setup(curl);
+    return {curl, [self = shared_from_this()](CURL* curl) {
+                self->release(curl);
+            }};
+}
+
+size_t CurlPool::idlehandles()
+{
+    std::lock_guard lock(mtx);
+    evictidle();
+    return idle.size();
+}
+
+std::shared_ptr<CurlPool> CurlPool::getdefault()
+{
+    static const auto pool = std::make_shared<CurlPool>(defaultPoolConfig);
+    return pool;
+}
+
+void CurlPool::setup(CURL* curl)
+{
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXAGE_CONN, (long)idletimeout.count());
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+}
+
+void CurlPool::release(CURL* curl)
+{
+    // reset keeps live connections and caches, only options are cleared
+    curl_easy_reset(curl);
+    std::lock_guard lock(mtx);
+    if (idle.size() < maxidle)
+    {
+        idle.emplace_back(curl, std::chrono::steady_clock::now());
+        return;
+    }
+    curl_easy_cleanup(curl);
+}
+
+void CurlPool::evictidle()
+{
+    auto expired = std::chrono::steady_clock::now() - idletimeout;
+    while (!idle.empty() && idle.front().second < expired)
+    {
+        curl_easy_cleanup(idle.front().first);
+        idle.pop_front();
+    }
+}
+
+void CurlPool::lockshare(CURL*, curl_lock_data data, curl_lock_access,
+                         void* userptr)
+{
+    static_cast<CurlPool*>(userptr)->sharelocks.at(data).lock();
+}
+
+void CurlPool::unlockshare(CURL*, curl_lock_data data, void* userptr)
+{
+    static_cast<CurlPool*>(userptr)->sharelocks.at(data).unlock();
+}
+
+} // namespace speech::helpers
@@ -0,0 +1,79 @@
+#include "speech/grpcoptions.hpp"
+
+#include "google/cloud/credentials.h"
+#include "google/cloud/grpc_options.h"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+
+namespace speech::helpers
+{
+
+static std::shared_ptr<google::cloud::Credentials>
+    getcredentials(const std::filesystem::path& keyfile)
+{
+    static std::mutex mtx;
+    static std::map<std::filesystem::path,
+                    std::shared_ptr<google::cloud::Credentials>>
+        credentials;
+    const auto path = std::filesystem::absolute(keyfile).lexically_normal();
+    std::lock_guard lock(mtx);
+    if (auto found = credentials.find(path); found != credentials.end())
+        return found->second;
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open key file: " + path.native());
+    auto created = google::cloud::MakeServiceAccountCredentials(
+        std::string(std::istreambuf_iterator<char>(ifs.rdbuf()), {}));
+    credentials.emplace(path, created);
+    return created;
+}
+
+google::cloud::Options getgrpcoptions(const connconfig_t& config)
+{
+    auto options = google::cloud::Options{}
+                       .set<google::cloud::UnifiedCredentialsOption>(
+                           getcredentials(config.keyfile))
+                       .set<google::cloud::GrpcNumChannelsOption>(
+                           config.channels);
+    if (!config.endpoint.empty())
+        options.set<google::cloud::EndpointOption>(config.endpoint);
+    if (config.keepalive.count() > 0)
+    {
+        // idle channels are pinged too, so first request after a pause does
+        // not find connection silently dropped by middlebox
+        grpc::ChannelArguments arguments;
+        arguments.SetInt(
+            GRPC_ARG_KEEPALIVE_TIME_MS,
+            (int)std::chrono::milliseconds(config.keepalive).count());
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, 10000);
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+        arguments.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+        options.set<google::cloud::GrpcChannelArgumentsNativeOption>(
+            std::move(arguments));
+    }
+    if (config.compression)
+        options.set<google::cloud::GrpcCompressionAlgorithmOption>(
+            GRPC_COMPRESS_GZIP);
+    return options;
+}
+
+google::cloud::Options
+    getcalloptions(const std::shared_ptr<CancelToken>& token)
+{
+    google::cloud::Options options;
+    if (auto deadline = token ? token->getdeadline() : std::nullopt)
+        options.set<google::cloud::GrpcSetupOption>(
+            [deadline = *deadline](grpc::ClientContext& context) {
+                // grpc takes system clock time, steady one is translated
+                context.set_deadline(
+                    std::chrono::system_clock::now() +
+                    std::chrono::duration_cast<
+                        std::chrono::system_clock::duration>(
+                        deadline - std::chrono::steady_clock::now()));
+            });
+    return options;
+}
+
+} // namespace speech::helpers
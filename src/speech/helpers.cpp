@@ -1,60 +1,251 @@
 #include "speech/helpers.hpp"
 
-#include "speech/tts/interfaces/texttovoice.hpp"
-
-#include <curl/curl.h>
-#include <curl/easy.h>
+#include "speech/cancel.hpp"
+#include "speech/curlmulti.hpp"
+#include "speech/mappedfile.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <future>
-#include <vector>
 
 namespace speech::helpers
 {
 
 using namespace std::chrono_literals;
-std::future<void> async;
+
+struct TransferCounters
+{
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> inplacebytes;
+    std::atomic<uint64_t> copiedbytes;
+    std::atomic<uint64_t> allocations;
+};
+
+static size_t StreamReadFunction(char* buffer, size_t size, size_t nitems,
+                                 chunkreader_t* reader)
+{
+    return (*reader)(buffer, size * nitems);
+}
+
+struct Response
+{
+    std::string* output;
+    TransferCounters* counters;
+};
 
 static size_t UploadWriteFunction(char* data, size_t size, size_t nmemb,
-                                  std::string* output)
+                                  Response* response)
 {
     size_t datasize{size * nmemb};
-    output->append(data, datasize);
+    auto capacity = response->output->capacity();
+    response->output->append(data, datasize);
+    response->counters->copiedbytes += datasize;
+    if (response->output->capacity() != capacity)
+        response->counters->allocations++;
     return datasize;
 }
 
+static size_t ChunkWriteFunction(char* data, size_t size, size_t nmemb,
+                                 chunkwriter_t* writer)
+{
+    size_t datasize{size * nmemb};
+    return (*writer)({data, datasize}) ? datasize : 0;
+}
+
 static size_t DownloadWriteFunction(char* data, size_t size, size_t nmemb,
                                     std::ofstream* ofs)
 {
     size_t datasize{size * nmemb};
     ofs->write(data, datasize);
-    return datasize;
+    return ofs->good() ? datasize : 0;
+}
+
+static constexpr auto jsonHeader{"Content-Type: application/json"};
+static constexpr auto flacHeader{"Content-Type: audio/x-flac; rate=16000;"};
+static constexpr auto l16Header{"Content-Type: audio/l16; rate=16000;"};
+static constexpr auto chunkedHeader{"Transfer-Encoding: chunked"};
+static constexpr auto noExpectHeader{"Expect:"};
+
+static int ProgressFunction(const CancelToken* token, curl_off_t, curl_off_t,
+                            curl_off_t, curl_off_t)
+{
+    return token->iscancelled() ? 1 : 0;
+}
+
+// transfer made for cancellable call is aborted once its token trips and is
+// never let run past its deadline, token is kept alive by caller until
+// transfer completes
+static void setupcancel(CURL* curl, const CancelToken* token)
+{
+    if (token == nullptr)
+        return;
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressFunction);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, token);
+    if (auto deadline = token->getdeadline())
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            *deadline - std::chrono::steady_clock::now());
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS,
+                         std::max<long>(1, (long)left.count()));
+    }
+}
+
+static const char* getaudioheader(audiotype type)
+{
+    return type == audiotype::linear16 ? l16Header : flacHeader;
+}
+
+static void setupupload(CURL* curl, const std::string& url, curl_slist* hlist,
+                        std::string_view data, Response* response)
+{
+    curl_easy_setopt(curl, CURLOPT_POST, 1);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.size());
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hlist);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, UploadWriteFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    response->counters->inplacebytes += data.size();
+}
+
+// error page sent with http error status is not taken as downloaded data
+static void setupdownload(CURL* curl, const std::string& url,
+                          std::ofstream* ofs)
+{
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DownloadWriteFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, ofs);
+}
+
+static std::string escapeurl(CURL* curl, const std::string& url,
+                             const std::string& text)
+{
+    auto escapedtext = curl_easy_escape(curl, text.c_str(), (int)text.length());
+    auto escapedurl = url + escapedtext;
+    curl_free(escapedtext);
+    return escapedurl;
+}
+
+// resources owned by transfer until curl multi engine completes it
+struct AsyncRequest
+{
+    std::string url;
+    std::string body;
+    std::shared_ptr<const std::string> audio;
+    chunkwriter_t writer;
+    completion_t complete;
+    Response response;
+    std::ofstream ofs;
+    curl_slist* hlist{};
+    std::shared_ptr<CancelToken> token{CancelScope::gettoken()};
+
+    ~AsyncRequest()
+    {
+        curl_slist_free_all(hlist);
+    }
+};
+
+// response is handed over to writer of request chunk by chunk
+static void submitupload(CurlPool::handle_t&& handle, const char* header,
+                         std::string_view data,
+                         std::shared_ptr<AsyncRequest> request,
+                         std::shared_ptr<TransferCounters> counters)
+{
+    if (handle && (request->hlist = curl_slist_append(nullptr, header)))
+    {
+        auto curl = handle.get();
+        request->response = {nullptr, counters.get()};
+        setupupload(curl, request->url, request->hlist, data,
+                    &request->response);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, ChunkWriteFunction);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &request->writer);
+        setupcancel(curl, request->token.get());
+        if (CurlMulti::getdefault()->submit(
+                std::move(handle), [request, counters](CURLcode res) {
+                    counters->requests++;
+                    request->complete(res == CURLE_OK);
+                }))
+            return;
+    }
+    request->complete(false);
 }
 
 bool Helpers::uploadData(const std::string& url, const std::string& datastr,
                          std::string& output)
+{
+    return uploadData(url, std::string_view{datastr}, output);
+}
+
+bool Helpers::uploadData(const std::string& url, std::string_view data,
+                         std::string& output)
 {
     CURLcode res{CURLE_FAILED_INIT};
-    if (auto curl = curl_easy_init(); curl != nullptr)
+    if (auto handle = pool->acquire())
     {
-        static constexpr auto header{"Content-Type: application/json"};
-        if (curl_slist * hlist{}; (hlist = curl_slist_append(hlist, header)))
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        if (curl_slist * hlist{};
+            (hlist = curl_slist_append(hlist, jsonHeader)))
         {
-            std::vector<char> data(datastr.begin(), datastr.end());
-            curl_easy_setopt(curl, CURLOPT_POST, 1);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, &data[0]);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.size());
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hlist);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, UploadWriteFunction);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &output);
-            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
+            Response response{&output, counters.get()};
+            setupupload(curl, url, hlist, data, &response);
             res = curl_easy_perform(curl); // synchronous file upload
             curl_slist_free_all(hlist);
+            counters->requests++;
+        }
+    }
+    return res == CURLE_OK;
+}
+
+// audio held by caller is sent as request body in place, without copying;
+// error page sent with http error status fails upload
+bool Helpers::uploadData(const std::string& url, audiotype type,
+                         std::string_view data, std::string& output)
+{
+    CURLcode res{CURLE_FAILED_INIT};
+    if (auto handle = pool->acquire())
+    {
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        if (curl_slist * hlist{};
+            (hlist = curl_slist_append(hlist, getaudioheader(type))))
+        {
+            Response response{&output, counters.get()};
+            setupupload(curl, url, hlist, data, &response);
+            curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+            res = curl_easy_perform(curl); // synchronous audio upload
+            curl_slist_free_all(hlist);
+            counters->requests++;
+        }
+    }
+    return res == CURLE_OK;
+}
+
+// response is handed over chunk by chunk, never collected by helpers
+bool Helpers::uploadData(const std::string& url, std::string_view data,
+                         chunkwriter_t writer)
+{
+    CURLcode res{CURLE_FAILED_INIT};
+    if (auto handle = pool->acquire())
+    {
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        if (curl_slist * hlist{};
+            (hlist = curl_slist_append(hlist, jsonHeader)))
+        {
+            Response response{nullptr, counters.get()};
+            setupupload(curl, url, hlist, data, &response);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, ChunkWriteFunction);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writer);
+            res = curl_easy_perform(curl); // synchronous streamed upload
+            curl_slist_free_all(hlist);
+            counters->requests++;
         }
-        curl_easy_cleanup(curl);
     }
     return res == CURLE_OK;
 }
@@ -63,28 +254,58 @@ bool Helpers::uploadFile(const std::string& url, const std::string& filepath,
                          std::string& output)
 {
     CURLcode res{CURLE_FAILED_INIT};
-    if (auto curl = curl_easy_init(); curl != nullptr)
+    if (auto handle = pool->acquire())
     {
-        static constexpr auto header{"Content-Type: audio/x-flac; rate=16000;"};
-        if (curl_slist * hlist{}; (hlist = curl_slist_append(hlist, header)))
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        if (curl_slist * hlist{};
+            (hlist = curl_slist_append(hlist, flacHeader)))
         {
-            auto size = std::filesystem::file_size(filepath);
-            std::vector<char> data(size);
-            std::ifstream ifs(filepath, std::ios::in | std::ifstream::binary);
-            ifs.read(&data[0], data.size());
-
-            curl_easy_setopt(curl, CURLOPT_POST, 1);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, &data[0]);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, size);
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hlist);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, UploadWriteFunction);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &output);
-            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
-            res = curl_easy_perform(curl); // synchronous file upload
+            if (MappedFile file(filepath); file)
+            {
+                Response response{&output, counters.get()};
+                setupupload(curl, url, hlist, file.view(), &response);
+                res = curl_easy_perform(curl); // synchronous file upload
+                counters->requests++;
+            }
             curl_slist_free_all(hlist);
         }
-        curl_easy_cleanup(curl);
+    }
+    return res == CURLE_OK;
+}
+
+bool Helpers::uploadStream(const std::string& url, chunkreader_t reader,
+                           std::string& output)
+{
+    return uploadStream(url, audiotype::flac, std::move(reader), output);
+}
+
+bool Helpers::uploadStream(const std::string& url, audiotype type,
+                           chunkreader_t reader, std::string& output)
+{
+    CURLcode res{CURLE_FAILED_INIT};
+    if (auto handle = pool->acquire())
+    {
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        curl_slist* hlist{};
+        // chunks are sent as produced, no waiting for 100-continue response
+        for (auto header :
+             {getaudioheader(type), chunkedHeader, noExpectHeader})
+            if (auto appended = curl_slist_append(hlist, header))
+                hlist = appended;
+        Response response{&output, counters.get()};
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_POST, 1);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, StreamReadFunction);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &reader);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hlist);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, UploadWriteFunction);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        res = curl_easy_perform(curl); // synchronous chunked upload
+        curl_slist_free_all(hlist);
+        counters->requests++;
     }
     return res == CURLE_OK;
 }
@@ -93,57 +314,116 @@ bool Helpers::downloadFile(const std::string& url, const std::string& text,
                            const std::string& filepath)
 {
     CURLcode res{CURLE_FAILED_INIT};
-    if (auto curl = curl_easy_init(); curl != nullptr)
+    if (auto handle = pool->acquire())
     {
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
         std::ofstream ofs(filepath, std::ios::out | std::ofstream::binary);
-        auto escapedtext =
-            curl_easy_escape(curl, text.c_str(), (int)text.length());
-        curl_easy_setopt(curl, CURLOPT_URL, (url + escapedtext).c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DownloadWriteFunction);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ofs);
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
+        setupdownload(curl, escapeurl(curl, url, text), &ofs);
         res = curl_easy_perform(curl); // synchronous file download
-        curl_free(escapedtext);
-        curl_easy_cleanup(curl);
+        counters->requests++;
+        ofs.close();
+        return res == CURLE_OK && !ofs.fail();
     }
-    return res == CURLE_OK;
+    return false;
 }
 
-std::shared_ptr<HelpersIf> HelpersFactory::create()
+bool Helpers::downloadData(const std::string& url, const std::string& text,
+                           std::string& output)
 {
-    return std::shared_ptr<Helpers>(new Helpers());
+    CURLcode res{CURLE_FAILED_INIT};
+    if (auto handle = pool->acquire())
+    {
+        auto curl = handle.get();
+        setupcancel(curl, CancelScope::gettoken().get());
+        const auto escapedurl = escapeurl(curl, url, text);
+        Response response{&output, counters.get()};
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_URL, escapedurl.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, UploadWriteFunction);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        res = curl_easy_perform(curl); // synchronous download to memory
+        counters->requests++;
+    }
+    return res == CURLE_OK;
 }
 
-bool Helpers::createasync(std::function<void()>&& func)
+void Helpers::uploadDataAsync(const std::string& url, std::string data,
+                              chunkwriter_t writer, completion_t complete)
 {
-    killasync();
-    async = std::async(std::launch::async, std::move(func));
-    return true;
+    auto request = std::make_shared<AsyncRequest>();
+    request->url = url;
+    request->body = std::move(data);
+    request->writer = std::move(writer);
+    request->complete = std::move(complete);
+    submitupload(pool->acquire(), jsonHeader, request->body, request,
+                 counters);
 }
 
-bool Helpers::isasyncrunning() const
+// audio shared with caller is sent in place, also by several transfers,
+// error page sent with http error status fails upload
+void Helpers::uploadDataAsync(const std::string& url, audiotype type,
+                              std::shared_ptr<const std::string> audio,
+                              chunkwriter_t writer, completion_t complete)
 {
-    return async.valid() && async.wait_for(0ms) != std::future_status::ready;
+    auto request = std::make_shared<AsyncRequest>();
+    request->url = url;
+    request->audio = std::move(audio);
+    request->writer = std::move(writer);
+    request->complete = std::move(complete);
+    auto handle = pool->acquire();
+    if (handle)
+        curl_easy_setopt(handle.get(), CURLOPT_FAILONERROR, 1L);
+    submitupload(std::move(handle), getaudioheader(type), *request->audio,
+                 request, counters);
 }
 
-bool Helpers::waitasync()
+void Helpers::downloadFileAsync(const std::string& url,
+                                const std::string& text,
+                                const std::string& filepath,
+                                completion_t complete)
 {
-    if (isasyncrunning())
+    if (auto handle = pool->acquire())
     {
-        async.wait();
-        return true;
+        auto request = std::make_shared<AsyncRequest>();
+        request->url = escapeurl(handle.get(), url, text);
+        request->complete = std::move(complete);
+        request->ofs.open(filepath, std::ios::out | std::ofstream::binary);
+        setupdownload(handle.get(), request->url, &request->ofs);
+        setupcancel(handle.get(), request->token.get());
+        auto finish = [request, counters = counters](CURLcode res) {
+            counters->requests++;
+            request->ofs.close();
+            request->complete(res == CURLE_OK && !request->ofs.fail());
+        };
+        if (CurlMulti::getdefault()->submit(std::move(handle),
+                                            std::move(finish)))
+            return;
+        request->complete(false);
+        return;
     }
-    return false;
+    complete(false);
+}
+
+Helpers::Helpers(std::shared_ptr<CurlPool> pool) :
+    pool{pool}, counters{std::make_shared<TransferCounters>()}
+{}
+
+transferstats_t Helpers::getstats() const
+{
+    return {counters->requests, counters->inplacebytes, counters->copiedbytes,
+            counters->allocations};
 }
 
-bool Helpers::killasync()
+std::shared_ptr<HelpersIf> HelpersFactory::create()
 {
-    if (isasyncrunning())
-    {
-        tts::TextToVoiceIf::kill();
-        return waitasync();
-    }
-    return false;
+    return std::shared_ptr<Helpers>(new Helpers(CurlPool::getdefault()));
+}
+
+std::shared_ptr<HelpersIf> HelpersFactory::create(const poolconfig_t& config)
+{
+    return std::shared_ptr<Helpers>(
+        new Helpers(std::make_shared<CurlPool>(config)));
 }
 
 std::string getrecordingcmd(const std::string& file,
@@ -157,4 +437,37 @@ std::string getrecordingcmd(const std::string& file,
            file + " silence -l 1 0.1 3.0% 1 " + ivtime + " 3.0%";
 }
 
+std::string getplaybackcmd(const std::string& file)
+{
+    return "play --no-show-progress " + file + " --type alsa";
+}
+
+// sentence ends at terminal punctuation followed by whitespace or at line
+// break, so numbers like 3.14 or trailing dots in names stay intact
+std::vector<std::string> splitsentences(const std::string& text)
+{
+    static const std::string terminals{".!?;"};
+    std::vector<std::string> sentences;
+    std::string sentence;
+    for (size_t pos{}; pos < text.size(); pos++)
+    {
+        auto sign = text[pos];
+        bool breaking =
+            sign == '\n' ||
+            (terminals.find(sign) != std::string::npos &&
+             (pos + 1 == text.size() || std::isspace((uint8_t)text[pos + 1])));
+        if (sign != '\n')
+            sentence.push_back(sign);
+        if (breaking || pos + 1 == text.size())
+        {
+            auto first = sentence.find_first_not_of(" \t\r");
+            if (first != std::string::npos)
+                sentences.push_back(sentence.substr(
+                    first, sentence.find_last_not_of(" \t\r") - first + 1));
+            sentence.clear();
+        }
+    }
+    return sentences;
+}
+
 } // namespace speech::helpers
@@ -0,0 +1,43 @@
+#include "speech/mappedfile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace speech::helpers
+{
+
+MappedFile::MappedFile(const std::string& filepath) : addr{MAP_FAILED}
+{
+    if (auto fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0)
+    {
+        if (struct stat st{}; fstat(fd, &st) == 0)
+        {
+            size = (size_t)st.st_size;
+            addr = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                        : nullptr;
+            if ((mapped = addr != MAP_FAILED) && size)
+                madvise(addr, size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapped && size)
+        munmap(addr, size);
+}
+
+MappedFile::operator bool() const
+{
+    return mapped;
+}
+
+std::string_view MappedFile::view() const
+{
+    return size ? std::string_view{(const char*)addr, size} : "";
+}
+
+} // namespace speech::helpers
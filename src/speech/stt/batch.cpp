@@ -0,0 +1,171 @@
+#include "speech/stt/batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+namespace stt
+{
+
+template <typename T>
+static T getle(std::string_view data, size_t offset)
+{
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+// stream info block follows magic, 20 bits of rate and 36 bits of total
+// samples are stored big endian at its offset 10
+static double getflacduration(std::string_view audio)
+{
+    if (audio.size() < 26 || !audio.starts_with("fLaC"))
+        return 0;
+    uint64_t bits{};
+    for (size_t pos{18}; pos < 26; pos++)
+        bits = (bits << 8) | (uint8_t)audio[pos];
+    auto rate = bits >> 44;
+    auto samples = bits & ((1ull << 36) - 1);
+    return rate ? (double)samples / (double)rate : 0;
+}
+
+static double getwavduration(std::string_view audio)
+{
+    uint32_t bytespersec{};
+    for (size_t offset{12}; offset + 8 <= audio.size();)
+    {
+        auto id = audio.substr(offset, 4);
+        auto size = getle<uint32_t>(audio, offset + 4);
+        if (id == "fmt " && offset + 24 <= audio.size())
+            bytespersec = getle<uint32_t>(audio, offset + 16);
+        else if (id == "data" && bytespersec)
+            return (double)std::min<size_t>(size, audio.size() - offset - 8) /
+                   bytespersec;
+        // chunks are word aligned
+        offset += 8 + (size_t)size + (size & 1);
+    }
+    return 0;
+}
+
+double getaudioduration(std::span<const std::byte> data, format type)
+{
+    std::string_view audio{(const char*)data.data(), data.size()};
+    if (type == format::flac)
+        return getflacduration(audio);
+    if (audio.size() >= 12 && audio.starts_with("RIFF") &&
+        audio.substr(8, 4) == "WAVE")
+        return getwavduration(audio);
+    return (double)audio.size() / sizeof(int16_t) / capture::sampleRate;
+}
+
+// workers block on whole requests, which backends may run on shared pool
+// themselves, so they have own pool, kept for all runs
+BatchTranscriber::BatchTranscriber(std::shared_ptr<TextFromVoiceIf> stt,
+                                   size_t concurrency) :
+    stt{stt}, concurrency{std::max<size_t>(1, concurrency)},
+    pool{std::make_shared<speech::helpers::ThreadPool>(this->concurrency)}
+{}
+
+std::vector<batchresult_t>
+    BatchTranscriber::run(const std::vector<batchinput_t>& inputs)
+{
+    std::vector<batchresult_t> results(inputs.size());
+    std::atomic<size_t> next{};
+    const auto start = std::chrono::steady_clock::now();
+    // each worker keeps one request in flight, results land at input index
+    speech::helpers::TaskGroup workers{pool, concurrency};
+    for (size_t worker{}; worker < std::min(concurrency, inputs.size());
+         worker++)
+        workers.submit([&]() {
+            for (size_t index{}; (index = next++) < inputs.size();)
+                results[index] = transcribe(inputs[index]);
+        });
+    workers.wait();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::vector<std::chrono::milliseconds> latencies;
+    stats = {};
+    stats.inputs = results.size();
+    stats.elapsed = elapsed.count();
+    for (const auto& result : results)
+    {
+        stats.failed += !result.error.empty();
+        stats.audio += result.duration;
+        latencies.push_back(result.latency);
+    }
+    if (stats.elapsed > 0)
+    {
+        stats.inputspersec = (double)stats.inputs / stats.elapsed;
+        stats.audiopersec = stats.audio / stats.elapsed;
+    }
+    if (!latencies.empty())
+    {
+        // nearest rank percentiles
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double share) {
+            auto rank = (size_t)std::ceil(share * (double)latencies.size());
+            return latencies[std::max<size_t>(rank, 1) - 1];
+        };
+        stats.p50 = percentile(0.50);
+        stats.p99 = percentile(0.99);
+    }
+    return results;
+}
+
+batchstats_t BatchTranscriber::getstats() const
+{
+    return stats;
+}
+
+batchresult_t BatchTranscriber::transcribe(const batchinput_t& input) const
+{
+    batchresult_t result{};
+    const auto start = std::chrono::steady_clock::now();
+    try
+    {
+        if (!input.audio.empty())
+        {
+            result.duration = getaudioduration(input.audio, input.type);
+            result.transcript =
+                stt->transcribe(input.audio, input.type, input.lang);
+        }
+        else
+        {
+            std::ifstream ifs(input.file, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+                throw std::runtime_error("Cannot open audio file: " +
+                                         input.file.native());
+            const auto audio =
+                std::string(std::istreambuf_iterator<char>(ifs.rdbuf()), {});
+            const auto bytes = std::as_bytes(std::span{audio});
+            if (audio.starts_with("fLaC"))
+            {
+                result.duration = getaudioduration(bytes, format::flac);
+                result.transcript =
+                    stt->transcribe(bytes, format::flac, input.lang);
+            }
+            else
+            {
+                result.duration = getaudioduration(bytes, format::linear16);
+                result.transcript = stt->transcribe(input.file, input.lang);
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        result.error = ex.what();
+    }
+    catch (...)
+    {
+        result.error = "Unknown error";
+    }
+    result.latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    return result;
+}
+
+} // namespace stt
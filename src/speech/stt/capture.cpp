@@ -0,0 +1,182 @@
+#include "speech/stt/capture.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace stt::capture
+{
+
+// samples moved from source to ring buffer at once, 20 ms of audio
+static constexpr size_t captureChunkSize{sampleRate / 50};
+// ring holds few seconds, so slow consumer does not lose audio
+static constexpr size_t ringCapacity{sampleRate * 4};
+
+RingBuffer::RingBuffer(size_t size) :
+    buffer(std::bit_ceil(std::max<size_t>(size, 2))), mask{buffer.size() - 1}
+{}
+
+size_t RingBuffer::write(std::span<const int16_t> samples)
+{
+    const auto writepos = head.load(std::memory_order_relaxed);
+    const auto readpos = tail.load(std::memory_order_acquire);
+    const auto size =
+        std::min(samples.size(), buffer.size() - (writepos - readpos));
+    const auto offset = writepos & mask;
+    const auto first = std::min(size, buffer.size() - offset);
+    std::memcpy(buffer.data() + offset, samples.data(),
+                first * sizeof(int16_t));
+    std::memcpy(buffer.data(), samples.data() + first,
+                (size - first) * sizeof(int16_t));
+    head.store(writepos + size, std::memory_order_release);
+    return size;
+}
+
+size_t RingBuffer::read(std::span<int16_t> samples)
+{
+    const auto readpos = tail.load(std::memory_order_relaxed);
+    const auto writepos = head.load(std::memory_order_acquire);
+    const auto size = std::min(samples.size(), writepos - readpos);
+    const auto offset = readpos & mask;
+    const auto first = std::min(size, buffer.size() - offset);
+    std::memcpy(samples.data(), buffer.data() + offset,
+                first * sizeof(int16_t));
+    std::memcpy(samples.data() + first, buffer.data(),
+                (size - first) * sizeof(int16_t));
+    tail.store(readpos + size, std::memory_order_release);
+    return size;
+}
+
+size_t RingBuffer::available() const
+{
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+}
+
+size_t RingBuffer::capacity() const
+{
+    return buffer.size();
+}
+
+Capture::Capture(std::shared_ptr<SourceIf> source,
+                 std::optional<vadconfig_t> vad,
+                 std::chrono::milliseconds duration) :
+    source{source}, realtime{source->isrealtime()},
+    limit{(uint64_t)duration.count() * sampleRate / 1000}, ring{ringCapacity}
+{
+    if (vad)
+        endpointer.emplace(*vad);
+}
+
+Capture::~Capture()
+{
+    stop();
+}
+
+bool Capture::start()
+{
+    if (running || producer.joinable())
+        return false;
+    if (!source->open())
+    {
+        // nothing will be captured, readers must not wait for samples
+        finished = true;
+        notify();
+        return false;
+    }
+    running = true;
+    producer = std::thread([this]() { run(); });
+    return true;
+}
+
+void Capture::stop()
+{
+    running = false;
+    release();
+    if (producer.joinable())
+        producer.join();
+}
+
+void Capture::cancel()
+{
+    running = false;
+    cancelled = true;
+    notify();
+    release();
+}
+
+size_t Capture::read(std::span<int16_t> samples)
+{
+    while (true)
+    {
+        const auto seen = signal.load();
+        if (cancelled)
+            return 0;
+        if (auto size = ring.read(samples))
+        {
+            release();
+            return size;
+        }
+        // samples written before finishing are visible once flag is set
+        if (finished)
+            return ring.read(samples);
+        signal.wait(seen);
+    }
+}
+
+capturestats_t Capture::getstats() const
+{
+    return {captured, dropped};
+}
+
+void Capture::run()
+{
+    std::vector<int16_t> chunk(captureChunkSize), utterance;
+    auto event{vadevent::none};
+    while (running && captured < limit && event != vadevent::ended)
+    {
+        auto size = source->read(chunk);
+        if (size == 0)
+            break;
+        std::span<const int16_t> samples{chunk.data(), size};
+        if (endpointer)
+        {
+            utterance.clear();
+            event = endpointer->process(samples, utterance);
+            samples = utterance;
+        }
+        size = (size_t)std::min<uint64_t>(samples.size(), limit - captured);
+        // producer of realtime source never blocks on consumer, audio
+        // device would overrun, other one waits for space instead
+        size_t written{};
+        while (true)
+        {
+            const auto seen = space.load();
+            written += ring.write(samples.subspan(written, size - written));
+            if (written == size || realtime || !running)
+                break;
+            notify();
+            space.wait(seen);
+        }
+        captured += written;
+        dropped += size - written;
+        notify();
+    }
+    source->close();
+    finished = true;
+    notify();
+}
+
+void Capture::notify()
+{
+    signal++;
+    signal.notify_one();
+}
+
+void Capture::release()
+{
+    space++;
+    space.notify_one();
+}
+
+} // namespace stt::capture
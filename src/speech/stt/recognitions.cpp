@@ -0,0 +1,58 @@
+#include "speech/stt/recognitions.hpp"
+
+#include <chrono>
+#include <exception>
+#include <thread>
+
+namespace stt
+{
+
+using namespace std::chrono_literals;
+
+// recognitions end in any order, so all are polled in steps of same length
+// as token waits use
+static constexpr auto pollInterval{1ms};
+
+std::optional<std::pair<size_t, transcript_t>>
+    getbest(std::vector<recognition_t>& recognitions, uint32_t confidence,
+            const speech::helpers::CancelToken& token)
+{
+    std::optional<std::pair<size_t, transcript_t>> best;
+    std::exception_ptr error;
+    std::vector<bool> ended(recognitions.size());
+    for (size_t pending{recognitions.size()}; pending > 0;)
+    {
+        if (token.iscancelled())
+            return std::nullopt;
+        bool progressed{false};
+        for (size_t idx{}; idx < recognitions.size(); idx++)
+        {
+            if (ended[idx] ||
+                recognitions[idx].wait_for(0s) != std::future_status::ready)
+                continue;
+            ended[idx] = true;
+            progressed = true;
+            pending--;
+            try
+            {
+                auto transcript = recognitions[idx].get();
+                if (transcript &&
+                    (!best || transcript->second > best->second.second))
+                    best = std::make_pair(idx, std::move(*transcript));
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            if (best && best->second.second >= confidence)
+                return best;
+        }
+        if (!progressed)
+            std::this_thread::sleep_for(pollInterval);
+    }
+    if (!best && error)
+        std::rethrow_exception(error);
+    return best;
+}
+
+} // namespace stt
@@ -0,0 +1,115 @@
+#include "speech/stt/recording.hpp"
+
+#include <chrono>
+#include <source_location>
+#include <thread>
+
+namespace stt
+{
+
+using namespace speech::helpers;
+using namespace std::chrono_literals;
+
+static constexpr auto recordingPollInterval{20ms};
+
+Recording::Recording(std::shared_ptr<logs::LogIf> logif,
+                     std::shared_ptr<shell::ShellIf> shell,
+                     const std::string& recordcmd,
+                     const std::filesystem::path& path,
+                     std::shared_ptr<CancelToken> token) :
+    logif{logif}, path{path}, command{shell},
+    cancel{token, [this]() { interrupt(); }}
+{
+    std::filesystem::remove(path);
+    // recorder blocks on external process for whole utterance, so it
+    // holds pool worker until then
+    recorder = tasks.async([this, recordcmd]() {
+        command.run(recordcmd);
+        finished = true;
+    });
+}
+
+Recording::Recording(std::shared_ptr<logs::LogIf> logif,
+                     std::shared_ptr<shell::ShellIf> shell,
+                     std::shared_ptr<capture::SourceIf> source,
+                     std::optional<capture::vadconfig_t> vad,
+                     std::shared_ptr<CancelToken> token) :
+    logif{logif}, command{shell},
+    capture{std::make_unique<capture::Capture>(source, vad)},
+    cancel{token, [this]() { interrupt(); }}
+{
+    if (!capture->start())
+        throw std::runtime_error("Cannot start audio capture for STT");
+}
+
+Recording::~Recording()
+{
+    // recording abandoned early, eg. by exception, stops its recorder,
+    // which would otherwise be waited for until it exits on its own
+    if (recorder.valid())
+    {
+        if (!finished)
+            command.kill();
+        recorder.wait();
+    }
+    if (capture)
+        if (auto stats = capture->getstats(); stats.dropped > 0 && logif)
+            logif->log(logs::level::warning,
+                       std::string{std::source_location::current()
+                                       .function_name()},
+                       "Captured audio samples dropped: " +
+                           str(stats.dropped));
+}
+
+// follows file being written by recorder, ends once recorder exits and all
+// written data has been consumed, captured samples are taken straight from
+// ring buffer
+size_t Recording::read(char* buffer, size_t size)
+{
+    if (capture)
+        return capture->read({(int16_t*)buffer, size / sizeof(int16_t)}) *
+               sizeof(int16_t);
+    while (!cancelled)
+    {
+        auto done = finished.load();
+        if (!ifs.is_open())
+            ifs.open(path, std::ios::in | std::ios::binary);
+        if (ifs.is_open())
+        {
+            ifs.clear();
+            ifs.read(buffer, (std::streamsize)size);
+            if (auto received = ifs.gcount(); received > 0)
+                return (size_t)received;
+        }
+        if (done)
+            return 0;
+        std::this_thread::sleep_for(recordingPollInterval);
+    }
+    return 0;
+}
+
+void Recording::stop()
+{
+    if (capture)
+        capture->stop();
+    else if (!finished)
+        command.kill();
+}
+
+audiotype Recording::gettype() const
+{
+    return capture ? audiotype::linear16 : audiotype::flac;
+}
+
+// runs on cancelling thread, reader is let go without waiting for capture
+// thread or recorder to end
+void Recording::interrupt()
+{
+    cancelled = true;
+    if (capture)
+        capture->cancel();
+    else
+        command.kill();
+}
+
+} // namespace stt
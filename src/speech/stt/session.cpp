@@ -0,0 +1,351 @@
+#include "speech/stt/session.hpp"
+
+#include <algorithm>
+
+namespace stt
+{
+
+using namespace speech::helpers;
+
+// source is read in pieces of 20 ms, as by capture
+static constexpr size_t captureChunkSize{capture::sampleRate / 50};
+
+static sessionconfig_t getconfig(sessionconfig_t config)
+{
+    config.queuesize = std::max<size_t>(config.queuesize, 1);
+    config.concurrency = std::max<size_t>(config.concurrency, 1);
+    return config;
+}
+
+ListenSession::ListenSession(std::shared_ptr<TextFromVoiceIf> stt,
+                             const sessionconfig_t& config,
+                             callback_t callback) :
+    stt{stt}, config{getconfig(config)}, callback{callback}
+{
+    if (!stt || !config.source || !callback)
+        throw std::runtime_error(
+            "Listen session needs backend, audio source and callback");
+}
+
+ListenSession::~ListenSession()
+{
+    stop();
+}
+
+bool ListenSession::start()
+{
+    {
+        std::lock_guard lock(mtx);
+        if (running || capturer.joinable())
+            return false;
+        running = true;
+        exhausted = finished = false;
+        // utterances dropped by previous stop are never delivered
+        delivered = captured;
+        token = std::make_shared<CancelToken>();
+    }
+    capturer = std::thread([this]() {
+        capture();
+        exhaust();
+    });
+    for (size_t worker{}; worker < config.concurrency; worker++)
+        recognizers.emplace_back(&ListenSession::recognize, this);
+    deliverer = std::thread(&ListenSession::deliver, this);
+    return true;
+}
+
+bool ListenSession::wait()
+{
+    std::unique_lock lock(mtx);
+    cv.wait(lock, [this]() { return !running || finished; });
+    return finished;
+}
+
+void ListenSession::stop()
+{
+    {
+        std::lock_guard lock(mtx);
+        if (!running)
+            return;
+        running = false;
+    }
+    cv.notify_all();
+    // also reaches recognitions started after it, as their tokens are linked
+    token->cancel();
+    capturer.join();
+    for (auto& recognizer : recognizers)
+        recognizer.join();
+    recognizers.clear();
+    deliverer.join();
+
+    std::lock_guard lock(mtx);
+    utterances.clear();
+    results.clear();
+    queue.depth = recognition.depth = delivery.depth = 0;
+}
+
+sessionstats_t ListenSession::getstats() const
+{
+    std::lock_guard lock(mtx);
+    auto result{stats};
+    result.queue = getstats(queue);
+    result.recognition = getstats(recognition);
+    result.delivery = getstats(delivery);
+    return result;
+}
+
+// endpointer is kept with its noise floor for whole session and reset
+// after each utterance, rest of chunk after end of utterance is trailing
+// silence and is dropped; source that is not realtime ends session capture
+// once exhausted, realtime one is reopened
+void ListenSession::capture()
+{
+    std::optional<capture::Endpointer> endpointer;
+    if (config.vad)
+        endpointer.emplace(*config.vad);
+    const auto limit = std::max<size_t>(
+        captureChunkSize,
+        (size_t)config.maxutterance.count() * capture::sampleRate / 1000);
+    const auto realtime = config.source->isrealtime();
+    auto delay{config.backoff};
+    std::vector<int16_t> chunk(captureChunkSize), samples, utterance;
+    while (isrunning())
+    {
+        if (config.source->open())
+        {
+            delay = config.backoff;
+            while (auto size = isrunning() ? config.source->read(chunk) : 0)
+            {
+                std::span<const int16_t> audio{chunk.data(), size};
+                auto event{capture::vadevent::none};
+                if (endpointer)
+                {
+                    samples.clear();
+                    event = endpointer->process(audio, samples);
+                    audio = samples;
+                }
+                utterance.insert(utterance.end(), audio.begin(), audio.end());
+                if (event != capture::vadevent::ended &&
+                    utterance.size() < limit)
+                    continue;
+                if (!push(std::move(utterance)))
+                    break;
+                utterance.clear();
+                if (endpointer)
+                    endpointer->reset();
+            }
+            config.source->close();
+            // utterance cut short by end of audio is still recognized
+            if (!utterance.empty() && !push(std::move(utterance)))
+                return;
+            utterance.clear();
+            if (endpointer)
+                endpointer->reset();
+            if (!realtime || !isrunning())
+                return;
+        }
+        {
+            std::lock_guard lock(mtx);
+            stats.sourcefailures++;
+        }
+        if (!backoff(delay))
+            return;
+    }
+}
+
+// next utterance waits for room in queue and among results not delivered,
+// so slow backend or callback pauses source instead of growing memory;
+// realtime source cannot be paused, so its utterance is dropped instead;
+// false when session was stopped
+bool ListenSession::push(std::vector<int16_t>&& samples)
+{
+    std::unique_lock lock(mtx);
+    auto hasroom = [this]() {
+        return utterances.size() < config.queuesize &&
+               results.size() < config.queuesize;
+    };
+    if (config.source->isrealtime())
+    {
+        if (running && !hasroom())
+        {
+            stats.dropped++;
+            return true;
+        }
+    }
+    else
+    {
+        const auto start = clock::now();
+        cv.wait(lock, [this, &hasroom]() { return !running || hasroom(); });
+        stats.stalled += std::chrono::duration_cast<std::chrono::milliseconds>(
+            clock::now() - start);
+    }
+    if (!running)
+        return false;
+    utterances.push_back({captured++, std::move(samples), clock::now()});
+    stats.utterances++;
+    enter(queue);
+    cv.notify_all();
+    return true;
+}
+
+// utterances already queued are still recognized and delivered, then
+// recognizers and deliverer end on their own
+void ListenSession::exhaust()
+{
+    {
+        std::lock_guard lock(mtx);
+        exhausted = true;
+    }
+    cv.notify_all();
+}
+
+bool ListenSession::isrunning() const
+{
+    std::lock_guard lock(mtx);
+    return running;
+}
+
+void ListenSession::recognize()
+{
+    while (true)
+    {
+        Utterance utterance;
+        {
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [this]() {
+                return !running || !utterances.empty() || exhausted;
+            });
+            if (!running || utterances.empty())
+                return;
+            utterance = std::move(utterances.front());
+            utterances.pop_front();
+            leave(queue, clock::now() - utterance.captured);
+            enter(recognition);
+            cv.notify_all();
+        }
+
+        const auto start = clock::now();
+        auto result = transcribe(utterance);
+
+        std::lock_guard lock(mtx);
+        leave(recognition, clock::now() - start);
+        if (!running)
+            return;
+        stats.transcripts += result.transcript ? 1 : 0;
+        stats.failed += result.error.empty() ? 0 : 1;
+        results.emplace(utterance.index, Result{std::move(result),
+                                                utterance.captured,
+                                                clock::now()});
+        enter(delivery);
+        cv.notify_all();
+    }
+}
+
+// transcripts are passed on in order of capture, each as soon as all
+// earlier ones were; callback throwing does not end delivery
+void ListenSession::deliver()
+{
+    while (true)
+    {
+        std::unique_lock lock(mtx);
+        auto drained = [this]() {
+            return exhausted && delivered == captured;
+        };
+        cv.wait(lock, [this, &drained]() {
+            return !running || results.contains(delivered) || drained();
+        });
+        if (!running)
+            return;
+        if (drained())
+        {
+            finished = true;
+            cv.notify_all();
+            return;
+        }
+        auto node = results.extract(delivered++);
+        auto& [result, captured, recognized] = node.mapped();
+        const auto now = clock::now();
+        leave(delivery, now - recognized);
+        result.latency =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                  captured);
+        cv.notify_all();
+        lock.unlock();
+        try
+        {
+            callback(result);
+        }
+        catch (...)
+        {
+            // result is lost to caller, but later ones are still delivered
+            lock.lock();
+            stats.callbackfailures++;
+        }
+    }
+}
+
+// recognition in scope of session token, so stop reaches it even when it
+// starts after stop was called
+sessionresult_t ListenSession::transcribe(const Utterance& utterance)
+{
+    sessionresult_t result{utterance.index, std::nullopt, {}, {}};
+    auto delay{config.backoff};
+    CancelScope scope{token};
+    for (size_t attempt{};; attempt++)
+    {
+        try
+        {
+            result.transcript = stt->transcribe(
+                std::as_bytes(std::span{utterance.samples}), format::linear16,
+                config.lang);
+            result.error.clear();
+            break;
+        }
+        catch (const std::exception& ex)
+        {
+            result.error = ex.what();
+        }
+        if (attempt == config.retries || !backoff(delay))
+            break;
+        std::lock_guard lock(mtx);
+        stats.retries++;
+    }
+    return result;
+}
+
+// false when session was stopped while waiting
+bool ListenSession::backoff(std::chrono::milliseconds& delay)
+{
+    std::unique_lock lock(mtx);
+    const auto stopped =
+        cv.wait_for(lock, delay, [this]() { return !running; });
+    delay = std::min(delay * 2, config.maxbackoff);
+    return !stopped;
+}
+
+void ListenSession::enter(Stage& stage)
+{
+    stage.depth++;
+    stage.peak = std::max(stage.peak, stage.depth);
+}
+
+void ListenSession::leave(Stage& stage, clock::duration spent)
+{
+    stage.depth -= stage.depth > 0 ? 1 : 0;
+    stage.count++;
+    stage.total += spent;
+    stage.max = std::max(stage.max, spent);
+}
+
+stagestats_t ListenSession::getstats(const Stage& stage)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    return {stage.depth, stage.peak,
+            stage.count ? duration_cast<milliseconds>(
+                              stage.total / (clock::rep)stage.count)
+                        : milliseconds{},
+            duration_cast<milliseconds>(stage.max)};
+}
+
+} // namespace stt
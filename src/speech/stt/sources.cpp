@@ -0,0 +1,330 @@
+#include "speech/stt/sources.hpp"
+
+#include <alsa/asoundlib.h>
+
+#define DR_FLAC_IMPLEMENTATION
+#include <dr_flac.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numbers>
+#include <optional>
+#include <thread>
+
+namespace stt::capture
+{
+
+static constexpr uint32_t alsaLatencyUs{100000};
+
+struct AlsaSource::Handler
+{
+  public:
+    explicit Handler(const std::string& device) : device{device}
+    {}
+
+    ~Handler()
+    {
+        close();
+    }
+
+    bool open()
+    {
+        if (pcm != nullptr)
+            return true;
+        if (snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, 0) < 0)
+        {
+            pcm = nullptr;
+            return false;
+        }
+        if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE,
+                               SND_PCM_ACCESS_RW_INTERLEAVED, 1, sampleRate,
+                               1, alsaLatencyUs) < 0 ||
+            snd_pcm_start(pcm) < 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    size_t read(std::span<int16_t> samples)
+    {
+        if (pcm == nullptr)
+            return 0;
+        while (true)
+        {
+            auto frames = snd_pcm_readi(pcm, samples.data(), samples.size());
+            if (frames >= 0)
+                return (size_t)frames;
+            // overrun or suspend, device is prepared again
+            if (snd_pcm_recover(pcm, (int)frames, 1) < 0)
+                return 0;
+        }
+    }
+
+    void close()
+    {
+        if (pcm != nullptr)
+        {
+            snd_pcm_drop(pcm);
+            snd_pcm_close(pcm);
+            pcm = nullptr;
+        }
+    }
+
+  private:
+    const std::string device;
+    snd_pcm_t* pcm{nullptr};
+};
+
+AlsaSource::AlsaSource(const std::string& device) :
+    handler{std::make_shared<Handler>(device)}
+{}
+AlsaSource::~AlsaSource() = default;
+
+bool AlsaSource::open()
+{
+    return handler->open();
+}
+
+size_t AlsaSource::read(std::span<int16_t> samples)
+{
+    return handler->read(samples);
+}
+
+void AlsaSource::close()
+{
+    handler->close();
+}
+
+bool AlsaSource::isrealtime() const
+{
+    return true;
+}
+
+// [sample rate, channels, interleaved samples]
+struct decoded_t
+{
+    uint32_t rate;
+    uint16_t channels;
+    std::vector<int16_t> samples;
+};
+
+template <typename T>
+static T getle(std::string_view data, size_t offset)
+{
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+static std::optional<decoded_t> decodewav(std::string_view audio)
+{
+    std::optional<decoded_t> decoded;
+    for (size_t offset{12}; offset + 8 <= audio.size();)
+    {
+        auto id = audio.substr(offset, 4);
+        auto size = std::min<size_t>(getle<uint32_t>(audio, offset + 4),
+                                     audio.size() - offset - 8);
+        auto chunk = audio.substr(offset + 8, size);
+        if (id == "fmt " && chunk.size() >= 16)
+        {
+            if (getle<uint16_t>(chunk, 0) != 1 ||
+                getle<uint16_t>(chunk, 14) != 16)
+                return std::nullopt;
+            decoded = decoded_t{getle<uint32_t>(chunk, 4),
+                                getle<uint16_t>(chunk, 2),
+                                {}};
+        }
+        else if (id == "data" && decoded)
+        {
+            decoded->samples.resize(chunk.size() / sizeof(int16_t));
+            std::memcpy(decoded->samples.data(), chunk.data(),
+                        decoded->samples.size() * sizeof(int16_t));
+            return decoded;
+        }
+        // chunks are word aligned
+        offset += 8 + size + (size & 1);
+    }
+    return std::nullopt;
+}
+
+static std::optional<decoded_t> decodeflac(std::string_view audio)
+{
+    unsigned int channels{}, rate{};
+    drflac_uint64 frames{};
+    auto pcm = drflac_open_memory_and_read_pcm_frames_s16(
+        audio.data(), audio.size(), &channels, &rate, &frames, nullptr);
+    if (pcm == nullptr)
+        return std::nullopt;
+    decoded_t decoded{rate, (uint16_t)channels, {}};
+    decoded.samples.assign(pcm, pcm + frames * channels);
+    drflac_free(pcm, nullptr);
+    return decoded;
+}
+
+static std::optional<decoded_t> decode(std::string_view audio)
+{
+    if (audio.starts_with("fLaC"))
+        return decodeflac(audio);
+    if (audio.size() >= 12 && audio.substr(0, 4) == "RIFF" &&
+        audio.substr(8, 4) == "WAVE")
+        return decodewav(audio);
+    return std::nullopt;
+}
+
+// half width of resampling filter in zero crossings of its sinc, longer
+// filter has steeper cutoff
+static constexpr double resampleZeros{16};
+
+// blackman window over [-1, 1]
+static double getwindow(double position)
+{
+    return 0.42 + 0.5 * std::cos(std::numbers::pi * position) +
+           0.08 * std::cos(2 * std::numbers::pi * position);
+}
+
+static double getsinc(double position)
+{
+    if (position == 0)
+        return 1;
+    const auto angle = std::numbers::pi * position;
+    return std::sin(angle) / angle;
+}
+
+// each output sample is interpolated by windowed sinc centered on its
+// position in input; when downsampling, sinc is stretched so its cutoff is
+// at new nyquist frequency, which low-pass filters tones that would alias
+static std::vector<int16_t> resample(const std::vector<int16_t>& input,
+                                     uint32_t rate)
+{
+    const auto ratio = (double)rate / sampleRate;
+    const auto cutoff = std::min(1.0, 1 / ratio);
+    const auto halfwidth = resampleZeros / cutoff;
+    const auto last = (double)input.size() - 1;
+    std::vector<int16_t> output((size_t)((double)input.size() / ratio));
+    for (size_t pos{}; pos < output.size(); pos++)
+    {
+        const auto center = (double)pos * ratio;
+        const auto first = std::max(0.0, std::ceil(center - halfwidth));
+        const auto end = std::min(last, std::floor(center + halfwidth));
+        double sum{};
+        for (auto index = first; index <= end; index++)
+        {
+            const auto offset = index - center;
+            sum += input[(size_t)index] * cutoff * getsinc(cutoff * offset) *
+                   getwindow(offset / halfwidth);
+        }
+        output[pos] = (int16_t)std::clamp(std::round(sum), -32768.0, 32767.0);
+    }
+    return output;
+}
+
+// channels are averaged and rate converted when needed
+static std::vector<int16_t> normalize(const decoded_t& decoded)
+{
+    if (decoded.rate == 0 || decoded.channels == 0)
+        return {};
+    const auto frames = decoded.samples.size() / decoded.channels;
+    std::vector<int16_t> mono(frames);
+    for (size_t frame{}; frame < frames; frame++)
+    {
+        int32_t sum{};
+        for (size_t channel{}; channel < decoded.channels; channel++)
+            sum += decoded.samples[frame * decoded.channels + channel];
+        mono[frame] = (int16_t)(sum / decoded.channels);
+    }
+    if (decoded.rate == sampleRate || mono.empty())
+        return mono;
+    return resample(mono, decoded.rate);
+}
+
+struct FileSource::Handler
+{
+  public:
+    Handler(const std::filesystem::path& path, bool realtime) :
+        path{path}, realtime{realtime}
+    {}
+
+    // file is decoded once, every next open replays it from beginning
+    bool open()
+    {
+        if (!decoded)
+        {
+            std::ifstream ifs(path, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+                return false;
+            const auto audio =
+                std::string(std::istreambuf_iterator<char>(ifs.rdbuf()), {});
+            auto content = decode(audio);
+            if (!content)
+                return false;
+            decoded = normalize(*content);
+        }
+        position = 0;
+        started = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    size_t read(std::span<int16_t> samples)
+    {
+        if (!decoded)
+            return 0;
+        auto size = std::min(samples.size(), decoded->size() - position);
+        std::copy_n(decoded->begin() + (std::ptrdiff_t)position, size,
+                    samples.begin());
+        position += size;
+        if (realtime)
+            std::this_thread::sleep_until(
+                started + std::chrono::microseconds(
+                              (int64_t)position * 1000000 / sampleRate));
+        return size;
+    }
+
+    void close()
+    {
+        position = decoded ? decoded->size() : 0;
+    }
+
+    bool isrealtime() const
+    {
+        return realtime;
+    }
+
+  private:
+    const std::filesystem::path path;
+    const bool realtime;
+    std::optional<std::vector<int16_t>> decoded;
+    size_t position{};
+    std::chrono::steady_clock::time_point started;
+};
+
+FileSource::FileSource(const std::filesystem::path& path, bool realtime) :
+    handler{std::make_shared<Handler>(path, realtime)}
+{}
+FileSource::~FileSource() = default;
+
+bool FileSource::open()
+{
+    return handler->open();
+}
+
+size_t FileSource::read(std::span<int16_t> samples)
+{
+    return handler->read(samples);
+}
+
+void FileSource::close()
+{
+    handler->close();
+}
+
+bool FileSource::isrealtime() const
+{
+    return handler->isrealtime();
+}
+
+} // namespace stt::capture
@@ -1,14 +1,66 @@
 #include "speech/stt/interfaces/textfromvoice.hpp"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/stt/sources.hpp"
+#include "speech/threadpool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
 
 namespace stt
 {
 
+using namespace speech::helpers;
+
+// recognitions of all instances hold at most half of shared workers, rest
+// is left for requests backends run on pool while they wait for them
+static TaskGroup& gettasks()
+{
+    static const auto pool = ThreadPool::getdefault();
+    static TaskGroup tasks{pool, std::max<size_t>(1, pool->getworkers() / 2)};
+    return tasks;
+}
+
 void stt::TextFromVoiceIf::kill()
 {
     shell::Factory::create<shell::lnx::bash::Shell>()->run(
         "killall -s KILL rec");
 }
 
+std::optional<transcript_t>
+    TextFromVoiceIf::transcribe(const std::filesystem::path& file,
+                                language lang)
+{
+    std::ifstream ifs(file, std::ios::in | std::ios::binary);
+    if (!ifs.is_open())
+        throw std::runtime_error("Cannot open audio file for STT");
+    const auto audio =
+        std::string(std::istreambuf_iterator<char>(ifs.rdbuf()), {});
+    if (audio.starts_with("fLaC"))
+        return transcribe(std::as_bytes(std::span{audio}), format::flac, lang);
+
+    capture::FileSource source{file};
+    if (!source.open())
+        throw std::runtime_error("Cannot decode audio file for STT");
+    std::vector<int16_t> samples, chunk(capture::sampleRate);
+    while (auto size = source.read(chunk))
+        samples.insert(samples.end(), chunk.begin(),
+                       chunk.begin() + (std::ptrdiff_t)size);
+    source.close();
+    return transcribe(std::as_bytes(std::span{samples}), format::linear16,
+                      lang);
+}
+
+// audio is owned by request, so caller may release its buffer at once;
+// caller runs recognition itself when too many are in flight
+std::future<std::optional<transcript_t>>
+    TextFromVoiceIf::transcribeasync(std::vector<std::byte> audio,
+                                     format type, language lang)
+{
+    return gettasks().async([this, audio = std::move(audio), type, lang]() {
+        return transcribe(audio, type, lang);
+    });
+}
+
 } // namespace stt
@@ -1,17 +1,24 @@
-#include "google/cloud/common_options.h"
-#include "google/cloud/credentials.h"
-#include "google/cloud/project.h"
 #include "google/cloud/speech/v2/speech_client.h"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/command.hpp"
+#include "speech/grpcoptions.hpp"
 #include "speech/helpers.hpp"
+#include "speech/threadpool.hpp"
 #include "speech/stt/interfaces/v2/googlecloud.hpp"
+#include "speech/stt/recognitions.hpp"
+#include "speech/stt/recording.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <optional>
 #include <source_location>
+#include <thread>
 #include <unordered_map>
 
 namespace stt::v2::googlecloud
@@ -19,17 +26,24 @@ namespace stt::v2::googlecloud
 
 using namespace speech::helpers;
 using namespace std::string_literals;
+using namespace std::chrono_literals;
 namespace speech = google::cloud::speech::v2;
 namespace speech_type = google::cloud::speech_v2;
 
 using recognizer_t =
     std::tuple<std::string, std::string, std::string, std::string>;
 
-static const std::filesystem::path keyFile = "../conf/key.json";
 static const std::filesystem::path audioDirectory = "audio";
 static const std::filesystem::path recordingName = "recording.flac";
 static const auto audioFilePath = audioDirectory / recordingName;
 static auto recordAudioCmd = getrecordingcmd(audioFilePath.native(), {});
+static constexpr size_t streamChunkSize{4096};
+// recognitions of one instance running on pool, caller of any further one
+// waits for one of them to end
+static constexpr size_t recognitionsInFlight{8};
+// unary call cannot be interrupted, so one abandoned keeps its place on pool
+// until it ends; without timeout given it is still bound by this one
+static constexpr std::chrono::seconds recognizeTimeout{60};
 // static const recognizer_t recognizerInfo = {"lukaszsttproject",
 // "europe-west4", "stt-region", "chirp_2"};
 static const recognizer_t recognizerInfo = {"lukaszsttproject", "eu",
@@ -40,6 +54,24 @@ static const std::unordered_map<language, std::string> langMap = {
     {language::english, "en-US"},
     {language::german, "de-DE"}};
 
+static std::string getlangcode(language lang)
+{
+    static constexpr auto deflang{language::polish};
+    return langMap.contains(lang) ? langMap.at(lang) : langMap.at(deflang);
+}
+
+// instances of same location and config share connection, only first one
+// creates it
+static std::shared_ptr<speech_type::SpeechConnection>
+    getconnection(const std::string& location, const connconfig_t& config)
+{
+    return Connections::getdefault()->get<speech_type::SpeechConnection>(
+        "speech.v2", location, config, [&location, &config]() {
+            return speech_type::MakeSpeechConnection(location,
+                                                     getgrpcoptions(config));
+        });
+}
+
 struct TextFromVoice::Handler
 {
   public:
@@ -47,7 +79,18 @@ struct TextFromVoice::Handler
         logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
         shell{shell::Factory::create<shell::lnx::bash::Shell>()},
         filesystem{this, audioDirectory},
-        google{this, keyFile, recognizerInfo, std::get<language>(config)}
+        google{this, recognizerInfo, std::get<language>(config)}
+    {
+        if (auto interval = std::get<std::string>(config); !interval.empty())
+            recordAudioCmd = getrecordingcmd(audioFilePath.native(), interval);
+    }
+
+    Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        options{std::get<options_t>(config)},
+        filesystem{this, audioDirectory},
+        google{this, recognizerInfo, std::get<language>(config)}
     {
         if (auto interval = std::get<std::string>(config); !interval.empty())
             recordAudioCmd = getrecordingcmd(audioFilePath.native(), interval);
@@ -57,7 +100,7 @@ struct TextFromVoice::Handler
         logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
         shell{std::get<std::shared_ptr<shell::ShellIf>>(config)},
         filesystem{this, audioDirectory},
-        google{this, keyFile, recognizerInfo, std::get<language>(config)}
+        google{this, recognizerInfo, std::get<language>(config)}
     {
         if (auto interval = std::get<std::string>(config); !interval.empty())
             recordAudioCmd = getrecordingcmd(audioFilePath.native(), interval);
@@ -65,33 +108,65 @@ struct TextFromVoice::Handler
 
     transcript_t listen()
     {
-        while (true)
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
         {
-            log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
-            shell->run(recordAudioCmd);
-            google.uploadaudio(audioFilePath);
-            if (auto transcript = google.gettranscript())
+            auto recording = record(token);
+            if (auto transcript =
+                    google.gettranscript(recording.get(), token))
                 return *transcript;
         }
+        log(logs::level::debug, "Listening cancelled");
         return {};
     }
 
     transcript_t listen(language lang)
     {
-        while (true)
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
+        {
+            auto recording = record(token);
+            if (auto transcript =
+                    google.gettranscript(recording.get(), lang, token))
+                return *transcript;
+        }
+        log(logs::level::debug, "Listening cancelled");
+        return {};
+    }
+
+    transcript_t listen(const std::vector<language>& langs)
+    {
+        if (langs.size() < 2)
+            return langs.empty() ? listen() : listen(langs.front());
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
         {
-            log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
-            shell->run(recordAudioCmd);
-            google.uploadaudio(audioFilePath);
-            if (auto transcript = google.gettranscript(lang))
+            auto recording = record(token);
+            if (auto transcript =
+                    google.gettranscript(recording.get(), langs, token))
                 return *transcript;
         }
+        log(logs::level::debug, "Listening cancelled");
         return {};
     }
 
+    std::optional<transcript_t> transcribe(std::span<const std::byte> audio,
+                                           format type, language lang)
+    {
+        return google.transcribe(audio, type, lang, canceller.gettoken());
+    }
+
+    void cancel()
+    {
+        auto pending = canceller.cancel();
+        log(logs::level::debug, "Recognition cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+    }
+
   private:
     const std::shared_ptr<logs::LogIf> logif;
     const std::shared_ptr<shell::ShellIf> shell;
+    const options_t options;
     class Filesystem
     {
       public:
@@ -135,131 +210,409 @@ struct TextFromVoice::Handler
         bool direxist;
     } filesystem;
 
+    std::unique_ptr<Recording> record(const std::shared_ptr<CancelToken>& token)
+    {
+        if (options.source)
+            return std::make_unique<Recording>(logif, shell, options.source,
+                                               options.vad, token);
+        log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
+        if (options.listening == mode::streaming)
+            return std::make_unique<Recording>(logif, shell, recordAudioCmd,
+                                               audioFilePath, token);
+        // only recorder spawned here is killed, others are left alone
+        Command command{shell};
+        CancelCallback kill{token, [&command]() { command.kill(); }};
+        command.run(recordAudioCmd);
+        return nullptr;
+    }
+
     class Google
     {
       public:
-        Google(const Handler* handler, const std::filesystem::path& keyfile,
-               recognizer_t recognizer, language lang) :
+        Google(const Handler* handler, recognizer_t recognizer,
+               language lang) :
             handler{handler},
-            client{speech_type::MakeSpeechConnection(
-                std::get<1>(recognizer),
-                google::cloud::Options{}
-                    .set<google::cloud::UnifiedCredentialsOption>(
-                        google::cloud::MakeServiceAccountCredentials(
-                            [](const std::filesystem::path& file) {
-                                std::ifstream ifs(file);
-                                if (!ifs.is_open())
-                                    throw std::runtime_error(
-                                        "Cannot open key file for STT");
-                                return std::string(
-                                    std::istreambuf_iterator<char>(ifs.rdbuf()),
-                                    {});
-                            }(keyfile))))},
-            lang{lang}
+            client{getconnection(std::get<1>(recognizer),
+                                 handler->options.connection)},
+            recognizer{"projects/" + std::get<0>(recognizer) + "/locations/" +
+                       std::get<1>(recognizer) + "/recognizers/" +
+                       std::get<2>(recognizer)},
+            config{getbaseconfig(std::get<3>(recognizer))}, lang{lang}
         {
-            const auto& config = request.mutable_config();
-            *config->mutable_auto_decoding_config() = {};
-            config->set_model(std::get<3>(recognizer));
-            request.set_recognizer("projects/" + std::get<0>(recognizer) +
-                                   "/locations/" + std::get<1>(recognizer) +
-                                   "/recognizers/" + std::get<2>(recognizer));
-            setlang(lang);
-
             handler->log(logs::level::info,
                          "Created v2::gcloud stt [langcode/langid]: " +
-                             getparams());
+                             getparams(lang));
         }
 
         ~Google()
         {
             handler->log(logs::level::info,
                          "Released v2::gcloud stt [langcode/langid]: " +
-                             getparams());
+                             getparams(lang));
         }
 
-        void uploadaudio(const std::filesystem::path& filepath)
+        std::optional<transcript_t>
+            gettranscript(Recording* recording,
+                          const std::shared_ptr<CancelToken>& token) const
         {
-            request.set_content([](const std::filesystem::path& path) {
-                std::ifstream ifs(path, std::ios::in | std::ios::binary);
-                if (!ifs.is_open())
-                    throw std::runtime_error("Cannot open audio file for STT");
-                return std::string(std::istreambuf_iterator<char>(ifs.rdbuf()),
-                                   {});
-            }(filepath));
+            return gettranscript(recording, lang, token);
+        }
+
+        // every call builds its own request, so nothing is shared between
+        // recognitions except read-only base config and client connection
+        std::optional<transcript_t>
+            gettranscript(Recording* recording, language lang,
+                          const std::shared_ptr<CancelToken>& token) const
+        {
+            if (token->iscancelled())
+                return std::nullopt;
+            if (recording != nullptr &&
+                handler->options.listening == mode::streaming)
+                return streamtranscript(recording, lang, token);
+            auto call = getrequest(getlistenformat(), lang);
+            call.set_content(recording != nullptr ? readaudio(recording)
+                                                  : readaudio(audioFilePath));
+            if (token->iscancelled())
+                return std::nullopt;
+            std::optional<transcript_t> transcript;
+            try
+            {
+                transcript = recognize(std::move(call), token);
+            }
+            catch (const std::exception& ex)
+            {
+                // listening goes on with next utterance
+                handler->log(logs::level::error, ex.what());
+                return std::nullopt;
+            }
             handler->log(logs::level::debug,
-                         "Uploaded audio to stt engine: " + filepath.native());
+                         "Speech detected for " + getparams(lang));
+            return transcript;
         }
 
-        std::optional<transcript_t> gettranscript()
+        // utterance is read in full, in streaming mode too, and recognized
+        // in every language at once, each by own request bound by own
+        // deadline; ones no longer needed are abandoned
+        std::optional<transcript_t>
+            gettranscript(Recording* recording,
+                          const std::vector<language>& langs,
+                          const std::shared_ptr<CancelToken>& token) const
         {
-            if (auto response = client.Recognize(request))
+            if (token->iscancelled())
+                return std::nullopt;
+            const auto audio = recording != nullptr ? readaudio(recording)
+                                                    : readaudio(audioFilePath);
+            std::vector<recognition_t> recognitions;
+            for (auto lang : langs)
+            {
+                auto call = getrequest(getlistenformat(), lang);
+                call.set_content(audio);
+                recognitions.push_back(handler->tasks.async(
+                    [this, call = std::move(call),
+                     request = getrequesttoken()]() {
+                        return recognize(call, getcalloptions(request));
+                    },
+                    *token));
+            }
+            std::optional<std::pair<size_t, transcript_t>> best;
+            try
+            {
+                best =
+                    getbest(recognitions, handler->options.confidence, *token);
+            }
+            catch (const std::exception& ex)
+            {
+                // every language failed, listening goes on with next utterance
+                handler->log(logs::level::error, ex.what());
+            }
+            if (!best)
             {
                 handler->log(logs::level::debug,
-                             "Received results: " +
-                                 str(response->results_size()));
-                for (const auto& result : response->results())
+                             "Cannot recognize transcript in any language");
+                return std::nullopt;
+            }
+            handler->log(logs::level::debug,
+                         "Speech detected for " +
+                             getparams(langs.at(best->first)));
+            return best->second;
+        }
+
+        // audio in memory is placed straight in request, with format and
+        // language of this call only
+        std::optional<transcript_t>
+            transcribe(std::span<const std::byte> audio, format type,
+                       language lang,
+                       const std::shared_ptr<CancelToken>& token) const
+        {
+            auto call = getrequest(type, lang);
+            call.mutable_content()->assign((const char*)audio.data(),
+                                           audio.size());
+            handler->log(logs::level::debug,
+                         "Transcribing audio from memory, bytes: " +
+                             str(audio.size()));
+            return recognize(std::move(call), token);
+        }
+
+        // unary call cannot be interrupted safely through synchronous client,
+        // so it runs on pool bound by deadline while caller is let go at once
+        // on cancel and result left behind is dropped
+        std::optional<transcript_t>
+            recognize(speech::RecognizeRequest call,
+                      const std::shared_ptr<CancelToken>& token) const
+        {
+            auto result = handler->tasks.async(
+                [this, call = std::move(call), request = getrequesttoken()]() {
+                    return recognize(call, getcalloptions(request));
+                },
+                *token);
+            // task dropped on cancel before it started leaves no result
+            if (!token->wait(result) || token->iscancelled())
+            {
+                handler->log(logs::level::debug, "Recognition abandoned");
+                return std::nullopt;
+            }
+            return result.get();
+        }
+
+        std::shared_ptr<CancelToken> getrequesttoken() const
+        {
+            const auto timeout = handler->options.timeout.count() > 0
+                                     ? handler->options.timeout
+                                     : recognizeTimeout;
+            return handler->canceller.gettoken(timeout);
+        }
+
+        // client copies share connection and are safe to use concurrently
+        std::optional<transcript_t>
+            recognize(const speech::RecognizeRequest& call,
+                      google::cloud::Options options) const
+        {
+            auto speechclient{client};
+            auto response = speechclient.Recognize(call, std::move(options));
+            // failed call is told apart from speech not recognized, so
+            // caller may retry or report it
+            if (!response)
+                throw std::runtime_error("Cannot recognize speech: " +
+                                         response.status().message());
+            handler->log(logs::level::debug,
+                         "Received results: " + str(response->results_size()));
+            for (const auto& result : response->results())
+            {
+                handler->log(logs::level::debug,
+                             "Received alternatives: " +
+                                 str(result.alternatives_size()));
+                for (const auto& alternative : result.alternatives())
                 {
+                    auto text = alternative.transcript();
+                    if (text.empty())
+                        continue;
+                    auto confid = alternative.confidence();
+                    auto quality = (uint32_t)std::lround(100 * confid);
                     handler->log(logs::level::debug,
-                                 "Received alternatives: " +
-                                     str(result.alternatives_size()));
-                    for (const auto& alternative : result.alternatives())
-                    {
-                        auto text = alternative.transcript();
-                        if (text.empty())
-                            continue;
-                        auto confid = alternative.confidence();
-                        auto quality = (uint32_t)std::lround(100 * confid);
-                        handler->log(logs::level::debug,
-                                     "Returning transcript [text/confid]: '" +
-                                         text + "'/" + str(confid));
-                        return std::make_optional<transcript_t>(std::move(text),
-                                                                quality);
-                    }
+                                 "Returning transcript [text/confid]: '" +
+                                     text + "'/" + str(confid));
+                    return std::make_optional<transcript_t>(std::move(text),
+                                                            quality);
                 }
             }
             handler->log(logs::level::debug, "Cannot recognize transcript");
             return std::nullopt;
         }
 
-        std::optional<transcript_t> gettranscript(language tmplang)
+        // audio is sent while still being recorded, first result marked as
+        // final by server ends recognition without waiting for recorder
+        std::optional<transcript_t>
+            streamtranscript(Recording* recording, language lang,
+                             const std::shared_ptr<CancelToken>& token) const
         {
-            const auto mainlang{lang};
-            setlang(tmplang);
-            auto transcript = gettranscript();
-            handler->log(logs::level::debug,
-                         "Speech detected for " + getparams());
-            setlang(mainlang);
+            auto streamclient{client};
+            auto stream = streamclient.AsyncStreamingRecognize(getcalloptions(
+                handler->canceller.gettoken(handler->options.timeout)));
+            // pending reads and writes complete at once, so loops below end
+            CancelCallback cancel{token, [&stream]() { stream->Cancel(); }};
+            speech::StreamingRecognizeRequest setup;
+            setup.set_recognizer(recognizer);
+            const auto& streaming = setup.mutable_streaming_config();
+            *streaming->mutable_config() = getconfig(getlistenformat(), lang);
+            streaming->mutable_streaming_features()->set_interim_results(
+                handler->options.interim != nullptr);
+            if (!stream->Start().get() ||
+                !stream->Write(setup, grpc::WriteOptions{}).get())
+            {
+                handler->log(logs::level::error,
+                             "Cannot start recognition stream: " +
+                                 stream->Finish().get().message());
+                recording->stop();
+                return std::nullopt;
+            }
+
+            using clock = std::chrono::steady_clock;
+            std::atomic<bool> done{false};
+            std::atomic<clock::time_point> lastsent{clock::now()};
+            // writer is paced by recording, so it holds pool worker for
+            // whole utterance; its group waits for it if call is left early
+            TaskGroup writers{ThreadPool::getdefault(), 1};
+            auto writer = writers.async([&]() {
+                speech::StreamingRecognizeRequest chunk;
+                std::string buffer(streamChunkSize, '\0');
+                while (!done)
+                {
+                    auto size = recording->read(buffer.data(), buffer.size());
+                    if (size == 0)
+                        break;
+                    chunk.set_audio(buffer.data(), size);
+                    if (!stream->Write(chunk, grpc::WriteOptions{}).get())
+                        break;
+                    lastsent = clock::now();
+                }
+                stream->WritesDone().get();
+            });
+
+            std::optional<transcript_t> transcript;
+            while (auto response = stream->Read().get())
+            {
+                if ((transcript = getfinal(*response)))
+                    break;
+            }
+            if (transcript)
+            {
+                auto latency = std::chrono::duration_cast<
+                    std::chrono::milliseconds>(clock::now() - lastsent.load());
+                handler->log(logs::level::debug,
+                             "Final transcript after last audio sent: " +
+                                 str(latency.count()) + " ms");
+            }
+
+            done = true;
+            recording->stop();
+            stream->Cancel();
+            writer.get();
+            while (stream->Read().get())
+                ;
+            if (auto status = stream->Finish().get();
+                !transcript && !status.ok())
+                handler->log(logs::level::error,
+                             "Recognition stream failed: " + status.message());
+            if (!transcript)
+                handler->log(logs::level::debug, "Cannot recognize transcript");
             return transcript;
         }
 
+        // interim hypotheses are passed to user callback as they arrive
+        std::optional<transcript_t>
+            getfinal(const speech::StreamingRecognizeResponse& response) const
+        {
+            for (const auto& result : response.results())
+            {
+                for (const auto& alternative : result.alternatives())
+                {
+                    auto text = alternative.transcript();
+                    if (text.empty())
+                        continue;
+                    if (!result.is_final())
+                    {
+                        if (handler->options.interim)
+                            handler->options.interim(text);
+                        break;
+                    }
+                    auto confid = alternative.confidence();
+                    auto quality = (uint32_t)std::lround(100 * confid);
+                    handler->log(logs::level::debug,
+                                 "Returning transcript [text/confid]: '" +
+                                     text + "'/" + str(confid));
+                    return std::make_optional<transcript_t>(std::move(text),
+                                                            quality);
+                }
+            }
+            return std::nullopt;
+        }
+
       private:
         const Handler* handler;
-        speech_type::SpeechClient client;
-        speech::RecognizeRequest request;
-        language lang;
+        const speech_type::SpeechClient client;
+        const std::string recognizer;
+        const speech::RecognitionConfig config;
+        const language lang;
+
+        static speech::RecognitionConfig getbaseconfig(const std::string& model)
+        {
+            speech::RecognitionConfig config;
+            config.set_model(model);
+            return config;
+        }
+
+        speech::RecognitionConfig getconfig(format type, language lang) const
+        {
+            auto call{config};
+            setdecoding(&call, type);
+            call.add_language_codes(getlangcode(lang));
+            return call;
+        }
+
+        speech::RecognizeRequest getrequest(format type, language lang) const
+        {
+            speech::RecognizeRequest call;
+            call.set_recognizer(recognizer);
+            *call.mutable_config() = getconfig(type, lang);
+            return call;
+        }
+
+        // raw samples have no header, so their layout is given explicitly
+        static void setdecoding(speech::RecognitionConfig* config, format type)
+        {
+            if (type == format::linear16)
+            {
+                const auto& decoding =
+                    config->mutable_explicit_decoding_config();
+                decoding->set_encoding(
+                    speech::ExplicitDecodingConfig::LINEAR16);
+                decoding->set_sample_rate_hertz(capture::sampleRate);
+                decoding->set_audio_channel_count(1);
+            }
+            else
+                *config->mutable_auto_decoding_config() = {};
+        }
 
-        void setlang(language lang)
+        // recorder writes flac, in process capture gives raw samples
+        format getlistenformat() const
         {
-            auto langId = [this](language newlang) {
-                this->lang = newlang;
-                static constexpr auto deflang{language::polish};
-                return langMap.contains(newlang) ? langMap.at(newlang)
-                                                 : langMap.at(deflang);
-            }(lang);
-
-            const auto& config = request.mutable_config();
-            config->language_codes_size()
-                ? config->set_language_codes(0, langId)
-                : config->add_language_codes(langId);
+            return handler->options.source ? format::linear16 : format::flac;
         }
 
-        std::string getparams() const
+        std::string readaudio(const std::filesystem::path& filepath) const
+        {
+            std::ifstream ifs(filepath, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+                throw std::runtime_error("Cannot open audio file for STT");
+            auto audio =
+                std::string(std::istreambuf_iterator<char>(ifs.rdbuf()), {});
+            handler->log(logs::level::debug,
+                         "Uploaded audio to stt engine: " + filepath.native());
+            return audio;
+        }
+
+        // captured samples are collected from ring buffer, no file involved
+        std::string readaudio(Recording* recording) const
+        {
+            std::string audio, buffer(streamChunkSize, '\0');
+            while (auto size = recording->read(buffer.data(), buffer.size()))
+                audio.append(buffer.data(), size);
+            handler->log(logs::level::debug,
+                         "Uploaded captured audio to stt engine, bytes: " +
+                             str(audio.size()));
+            return audio;
+        }
+
+        static std::string getparams(language lang)
         {
             auto langid = (std::underlying_type_t<decltype(lang)>)lang;
             auto langcode = langMap.contains(lang) ? langMap.at(lang) : "UNDEF";
             return langcode + "/" + str(langid);
         }
     } google;
+    // both are internally synchronized and used by const recognitions
+    mutable Canceller canceller;
+    mutable TaskGroup tasks{ThreadPool::getdefault(), recognitionsInFlight};
 
     void log(
         logs::level level, const std::string& msg,
@@ -298,4 +651,21 @@ transcript_t TextFromVoice::listen(language lang)
     return handler->listen(lang);
 }
 
+transcript_t TextFromVoice::listen(const std::vector<language>& langs)
+{
+    return handler->listen(langs);
+}
+
+std::optional<transcript_t>
+    TextFromVoice::transcribe(std::span<const std::byte> audio, format type,
+                              language lang)
+{
+    return handler->transcribe(audio, type, lang);
+}
+
+void TextFromVoice::cancel()
+{
+    handler->cancel();
+}
+
 } // namespace stt::v2::googlecloud
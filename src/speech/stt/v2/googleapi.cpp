@@ -1,16 +1,23 @@
 #include "speech/stt/interfaces/v2/googleapi.hpp"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/command.hpp"
 #include "speech/helpers.hpp"
+#include "speech/stt/recognitions.hpp"
+#include "speech/stt/recording.hpp"
 
 #include <nlohmann/json.hpp>
 
+#include <atomic>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <optional>
 #include <source_location>
+#include <thread>
 #include <unordered_map>
 
 namespace stt::v2::googleapi
@@ -19,6 +26,7 @@ namespace stt::v2::googleapi
 using json = nlohmann::json;
 using namespace speech::helpers;
 using namespace std::string_literals;
+using namespace std::chrono_literals;
 
 static const std::filesystem::path configFile = "../conf/init.json";
 static const std::filesystem::path audioDirectory = "audio";
@@ -27,6 +35,7 @@ static const auto audioFilePath = audioDirectory / recordingName;
 static auto recordAudioCmd = getrecordingcmd(audioFilePath.native(), {});
 static const auto convUri = "http://www.google.com/speech-api/v2/recognize"s;
 static const auto resultSignature = "transcript"s;
+static constexpr size_t streamChunkSize{4096};
 
 static const std::unordered_map<language, std::string> langMap = {
     {language::polish, "pl-PL"},
@@ -47,6 +56,18 @@ struct TextFromVoice::Handler
             recordAudioCmd = getrecordingcmd(audioFilePath.native(), interval);
     }
 
+    Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        helpers{speech::helpers::HelpersFactory::create()},
+        options{std::get<options_t>(config)},
+        filesystem{this, audioDirectory},
+        google{this, configFile, std::get<language>(config)}
+    {
+        if (auto interval = std::get<std::string>(config); !interval.empty())
+            recordAudioCmd = getrecordingcmd(audioFilePath.native(), interval);
+    }
+
     Handler(const configall_t& config) :
         logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
         shell{std::get<std::shared_ptr<shell::ShellIf>>(config)},
@@ -60,32 +81,64 @@ struct TextFromVoice::Handler
 
     transcript_t listen()
     {
-        while (true)
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
         {
-            log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
-            shell->run(recordAudioCmd);
-            if (auto transcript = google.gettranscript())
+            auto recording = record(token);
+            if (auto transcript = google.gettranscript(recording.get()))
                 return *transcript;
         }
+        log(logs::level::debug, "Listening cancelled");
         return {};
     }
 
     transcript_t listen(language lang)
     {
-        while (true)
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
+        {
+            auto recording = record(token);
+            if (auto transcript = google.gettranscript(recording.get(), lang))
+                return *transcript;
+        }
+        log(logs::level::debug, "Listening cancelled");
+        return {};
+    }
+
+    transcript_t listen(const std::vector<language>& langs)
+    {
+        if (langs.size() < 2)
+            return langs.empty() ? listen() : listen(langs.front());
+        const auto token = canceller.gettoken();
+        while (!token->iscancelled())
         {
-            log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
-            shell->run(recordAudioCmd);
-            if (auto transcript = google.gettranscript(lang))
+            auto recording = record(token);
+            if (auto transcript =
+                    google.gettranscript(recording.get(), langs, token))
                 return *transcript;
         }
+        log(logs::level::debug, "Listening cancelled");
         return {};
     }
 
+    std::optional<transcript_t> transcribe(std::span<const std::byte> audio,
+                                           format type, language lang)
+    {
+        return google.transcribe(audio, type, lang);
+    }
+
+    void cancel()
+    {
+        auto pending = canceller.cancel();
+        log(logs::level::debug, "Recognition cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+    }
+
   private:
     const std::shared_ptr<logs::LogIf> logif;
     const std::shared_ptr<shell::ShellIf> shell;
     const std::shared_ptr<speech::helpers::HelpersIf> helpers;
+    const options_t options;
     class Filesystem
     {
       public:
@@ -129,6 +182,22 @@ struct TextFromVoice::Handler
         bool direxist;
     } filesystem;
 
+    std::unique_ptr<Recording> record(const std::shared_ptr<CancelToken>& token)
+    {
+        if (options.source)
+            return std::make_unique<Recording>(logif, shell, options.source,
+                                               options.vad, token);
+        log(logs::level::debug, "Recording voice by: " + recordAudioCmd);
+        if (options.listening == mode::streaming)
+            return std::make_unique<Recording>(logif, shell, recordAudioCmd,
+                                               audioFilePath, token);
+        // only recorder spawned here is killed, others are left alone
+        Command command{shell};
+        CancelCallback kill{token, [&command]() { command.kill(); }};
+        command.run(recordAudioCmd);
+        return nullptr;
+    }
+
     class Google
     {
       public:
@@ -148,84 +217,241 @@ struct TextFromVoice::Handler
                         "Cannot get STT key from config file");
                 }
                 return sttConfig["key"].get<std::string>();
-            }(configfile)}
+            }(configfile)},
+            lang{lang}
         {
-            setlang(lang);
-
             handler->log(logs::level::info,
                          "Created v2::gapi stt [langcode/langid]: " +
-                             getparams());
+                             getparams(lang));
         }
 
         ~Google()
         {
             handler->log(logs::level::info,
                          "Released v2::gapi stt [langcode/langid]: " +
-                             getparams());
+                             getparams(lang));
         }
 
-        std::optional<transcript_t> gettranscript()
+        std::optional<transcript_t> gettranscript(Recording* recording) const
         {
+            return gettranscript(recording, lang);
+        }
+
+        // url is built per call, so recognitions share nothing but the key;
+        // transfers run on caller thread, as they send audio caller owns, and
+        // are aborted by curl once cancelled or past deadline
+        std::optional<transcript_t> gettranscript(Recording* recording,
+                                                  language lang) const
+        {
+            CancelScope scope{
+                handler->canceller.gettoken(handler->options.timeout)};
             std::string result;
-            handler->helpers->uploadFile(url, audioFilePath, result);
+            const auto url = geturl(lang);
+            if (recording != nullptr)
+                handler->helpers->uploadStream(
+                    url, recording->gettype(),
+                    [recording](char* buffer, size_t size) {
+                        return recording->read(buffer, size);
+                    },
+                    result);
+            else
+                handler->helpers->uploadFile(url, audioFilePath, result);
+            auto transcript = parseresult(result);
+            handler->log(logs::level::debug,
+                         "Speech detected for " + getparams(lang));
+            return transcript;
+        }
+
+        // utterance is read in full and sent in every language at once, its
+        // transfers run on curl multi engine and share only audio owned by
+        // them, so ones no longer needed are aborted and left behind
+        std::optional<transcript_t>
+            gettranscript(Recording* recording,
+                          const std::vector<language>& langs,
+                          const std::shared_ptr<CancelToken>& token) const
+        {
+            if (token->iscancelled())
+                return std::nullopt;
+            const auto audio = std::make_shared<const std::string>(
+                recording != nullptr ? readaudio(recording)
+                                     : readaudio(audioFilePath));
+            const auto type =
+                recording != nullptr ? recording->gettype() : audiotype::flac;
+            std::vector<recognition_t> recognitions;
+            std::vector<std::shared_ptr<CancelToken>> requests;
+            for (auto lang : langs)
+            {
+                auto request =
+                    handler->canceller.gettoken(handler->options.timeout);
+                requests.push_back(request);
+                recognitions.push_back(recognize(geturl(lang), type, audio,
+                                                 request));
+            }
+            std::optional<std::pair<size_t, transcript_t>> best;
+            try
+            {
+                best =
+                    getbest(recognitions, handler->options.confidence, *token);
+            }
+            catch (const std::exception& ex)
+            {
+                // every language failed, listening goes on with next utterance
+                handler->log(logs::level::error, ex.what());
+            }
+            for (const auto& request : requests)
+                request->cancel();
+            if (!best)
+            {
+                handler->log(logs::level::debug,
+                             "Cannot recognize transcript in any language");
+                return std::nullopt;
+            }
+            handler->log(logs::level::debug,
+                         "Speech detected for " +
+                             getparams(langs.at(best->first)));
+            return best->second;
+        }
+
+        // audio in memory is sent as request body, language of this call
+        // only is put in separate url
+        std::optional<transcript_t> transcribe(std::span<const std::byte> audio,
+                                               format type,
+                                               language lang) const
+        {
+            std::string result;
+            handler->log(logs::level::debug,
+                         "Transcribing audio from memory, bytes: " +
+                             str(audio.size()));
+            CancelScope scope{
+                handler->canceller.gettoken(handler->options.timeout)};
+            // failed request is told apart from speech not recognized
+            if (!handler->helpers->uploadData(
+                    geturl(lang),
+                    type == format::flac ? audiotype::flac
+                                         : audiotype::linear16,
+                    {(const char*)audio.data(), audio.size()}, result))
+                throw std::runtime_error("Cannot recognize speech for " +
+                                         getparams(lang));
+            return parseresult(result);
+        }
+
+        std::optional<transcript_t>
+            parseresult(const std::string& result) const
+        {
+            auto transcript = findtranscript(result);
+            if (transcript)
+                handler->log(logs::level::debug,
+                             "Returning transcript [text/quality]: '" +
+                                 transcript->first + "'/" +
+                                 str(transcript->second));
+            else
+                handler->log(logs::level::debug,
+                             "Cannot recognize transcript");
+            return transcript;
+        }
+
+      private:
+        const Handler* handler;
+        const std::string key;
+        const language lang;
+
+        // response is collected and parsed by completion on engine thread,
+        // which owns all it uses, as recognition may be left behind
+        recognition_t recognize(const std::string& url, audiotype type,
+                                std::shared_ptr<const std::string> audio,
+                                std::shared_ptr<CancelToken> token) const
+        {
+            struct Request
+            {
+                std::string result;
+                std::promise<std::optional<transcript_t>> transcript;
+            };
+            auto request = std::make_shared<Request>();
+            auto recognition = request->transcript.get_future();
+            CancelScope scope{token};
+            handler->helpers->uploadDataAsync(
+                url, type, audio,
+                [request](std::string_view chunk) {
+                    request->result.append(chunk);
+                    return true;
+                },
+                [request](bool done) {
+                    if (!done)
+                    {
+                        request->transcript.set_exception(
+                            std::make_exception_ptr(std::runtime_error(
+                                "Cannot recognize speech, request failed")));
+                        return;
+                    }
+                    try
+                    {
+                        request->transcript.set_value(
+                            findtranscript(request->result));
+                    }
+                    catch (...)
+                    {
+                        request->transcript.set_exception(
+                            std::current_exception());
+                    }
+                });
+            return recognition;
+        }
+
+        static std::optional<transcript_t>
+            findtranscript(const std::string& result)
+        {
             if (auto startpos = result.find("{\"transcript\"");
                 startpos != std::string::npos)
             {
                 if (auto endpos = result.substr(startpos).find("}");
                     endpos != std::string::npos)
                 {
-                    auto jsondata{result.substr(startpos, endpos + 1)};
-                    // std::cout << "stt json: " << jsondata << std::endl;
-                    auto first = json::parse(std::move(jsondata));
+                    auto first = json::parse(
+                        result.substr(startpos, endpos + 1));
                     auto text = first["transcript"].get<std::string>();
                     auto confid = first["confidence"].get<double>();
                     auto quality = (uint32_t)std::lround(100 * confid);
-                    handler->log(logs::level::debug,
-                                 "Returning transcript [text/confid]: '" +
-                                     text + "'/" + str(confid));
                     return std::make_optional<transcript_t>(std::move(text),
                                                             quality);
                 }
             }
-            handler->log(logs::level::debug, "Cannot recognize transcript");
             return std::nullopt;
         }
 
-        std::optional<transcript_t> gettranscript(language tmplang)
+        std::string readaudio(const std::filesystem::path& filepath) const
         {
-            const auto mainlang{lang};
-            setlang(tmplang);
-            auto transcript = gettranscript();
-            handler->log(logs::level::debug,
-                         "Speech detected for " + getparams());
-            setlang(mainlang);
-            return transcript;
+            std::ifstream ifs(filepath, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+                throw std::runtime_error("Cannot open audio file for STT");
+            return std::string(std::istreambuf_iterator<char>(ifs.rdbuf()),
+                               {});
         }
 
-      private:
-        const Handler* handler;
-        const std::string key;
-        language lang;
-        std::string url;
+        std::string readaudio(Recording* recording) const
+        {
+            std::string audio, buffer(streamChunkSize, '\0');
+            while (auto size = recording->read(buffer.data(), buffer.size()))
+                audio.append(buffer.data(), size);
+            return audio;
+        }
 
-        void setlang(language lang)
+        std::string geturl(language lang) const
         {
-            auto langId = [this](language newlang) {
-                this->lang = newlang;
-                static constexpr auto deflang{language::polish};
-                return langMap.contains(newlang) ? langMap.at(newlang)
+            static constexpr auto deflang{language::polish};
+            auto langId = langMap.contains(lang) ? langMap.at(lang)
                                                  : langMap.at(deflang);
-            }(lang);
-            url = std::string(convUri) + "?lang=" + langId + "&key=" + key;
+            return std::string(convUri) + "?lang=" + langId + "&key=" + key;
         }
 
-        std::string getparams() const
+        static std::string getparams(language lang)
         {
             auto langid = (std::underlying_type_t<decltype(lang)>)lang;
             auto langcode = langMap.contains(lang) ? langMap.at(lang) : "UNDEF";
             return langcode + "/" + str(langid);
         }
     } google;
+    // internally synchronized and used by const recognitions
+    mutable Canceller canceller;
 
     void log(
         logs::level level, const std::string& msg,
@@ -264,4 +490,21 @@ transcript_t TextFromVoice::listen(language lang)
     return handler->listen(lang);
 }
 
+transcript_t TextFromVoice::listen(const std::vector<language>& langs)
+{
+    return handler->listen(langs);
+}
+
+std::optional<transcript_t>
+    TextFromVoice::transcribe(std::span<const std::byte> audio, format type,
+                              language lang)
+{
+    return handler->transcribe(audio, type, lang);
+}
+
+void TextFromVoice::cancel()
+{
+    handler->cancel();
+}
+
 } // namespace stt::v2::googleapi
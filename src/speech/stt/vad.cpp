@@ -0,0 +1,296 @@
+#include "speech/stt/vad.hpp"
+
+#include "speech/stt/capture.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace stt::capture
+{
+
+// decision is made every 10 ms of audio
+static constexpr size_t frameSize{sampleRate / 100};
+// noise never assumed below -60 dBFS, so digital silence is not a reference
+static constexpr double minNoiseFloor{32768.0 * 32768.0 * 1e-6};
+// share of sign changes above which quiet frame is taken as fricative
+static constexpr double fricativeRate{0.3};
+
+using energy_t = uint64_t (*)(std::span<const int16_t>);
+using crossings_t = uint32_t (*)(std::span<const int16_t>);
+
+uint64_t getenergyscalar(std::span<const int16_t> samples)
+{
+    uint64_t energy{};
+    for (auto sample : samples)
+        energy += (uint64_t)((int32_t)sample * sample);
+    return energy;
+}
+
+uint32_t getzerocrossingsscalar(std::span<const int16_t> samples)
+{
+    uint32_t crossings{};
+    for (size_t pos{1}; pos < samples.size(); pos++)
+        crossings += (samples[pos - 1] ^ samples[pos]) < 0;
+    return crossings;
+}
+
+// squares are summed in pairs by multiply-add, pair sum fits in unsigned 32
+// bits only, so it is widened before accumulating; sign changes are found
+// as sign bit of xor with neighbour and counted over byte mask
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static uint64_t
+    energyavx2(std::span<const int16_t> samples)
+{
+    const auto zero = _mm256_setzero_si256();
+    auto sum = _mm256_setzero_si256();
+    size_t pos{};
+    for (; pos + 16 <= samples.size(); pos += 16)
+    {
+        auto data = _mm256_loadu_si256((const __m256i*)(samples.data() + pos));
+        auto squares = _mm256_madd_epi16(data, data);
+        sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(squares, zero));
+        sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(squares, zero));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256((__m256i*)lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           getenergyscalar(samples.subspan(pos));
+}
+
+__attribute__((target("avx2"))) static uint32_t
+    crossingsavx2(std::span<const int16_t> samples)
+{
+    uint32_t crossings{};
+    size_t pos{};
+    for (; pos + 17 <= samples.size(); pos += 16)
+    {
+        auto data = _mm256_loadu_si256((const __m256i*)(samples.data() + pos));
+        auto next =
+            _mm256_loadu_si256((const __m256i*)(samples.data() + pos + 1));
+        auto signs =
+            (uint32_t)_mm256_movemask_epi8(_mm256_xor_si256(data, next));
+        crossings += (uint32_t)std::popcount(signs & 0xAAAAAAAAu);
+    }
+    return crossings + getzerocrossingsscalar(samples.subspan(pos));
+}
+
+__attribute__((target("sse2"))) static uint64_t
+    energysse2(std::span<const int16_t> samples)
+{
+    const auto zero = _mm_setzero_si128();
+    auto sum = _mm_setzero_si128();
+    size_t pos{};
+    for (; pos + 8 <= samples.size(); pos += 8)
+    {
+        auto data = _mm_loadu_si128((const __m128i*)(samples.data() + pos));
+        auto squares = _mm_madd_epi16(data, data);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(squares, zero));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(squares, zero));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128((__m128i*)lanes, sum);
+    return lanes[0] + lanes[1] + getenergyscalar(samples.subspan(pos));
+}
+
+__attribute__((target("sse2"))) static uint32_t
+    crossingssse2(std::span<const int16_t> samples)
+{
+    uint32_t crossings{};
+    size_t pos{};
+    for (; pos + 9 <= samples.size(); pos += 8)
+    {
+        auto data = _mm_loadu_si128((const __m128i*)(samples.data() + pos));
+        auto next = _mm_loadu_si128((const __m128i*)(samples.data() + pos + 1));
+        auto signs = (uint32_t)_mm_movemask_epi8(_mm_xor_si128(data, next));
+        crossings += (uint32_t)std::popcount(signs & 0xAAAAu);
+    }
+    return crossings + getzerocrossingsscalar(samples.subspan(pos));
+}
+
+static std::pair<energy_t, crossings_t> getkernels()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {energyavx2, crossingsavx2};
+    if (__builtin_cpu_supports("sse2"))
+        return {energysse2, crossingssse2};
+    return {getenergyscalar, getzerocrossingsscalar};
+}
+#elif defined(__aarch64__)
+static uint64_t energyneon(std::span<const int16_t> samples)
+{
+    auto sum = vdupq_n_u64(0);
+    size_t pos{};
+    for (; pos + 8 <= samples.size(); pos += 8)
+    {
+        auto data = vld1q_s16(samples.data() + pos);
+        auto lo = vmull_s16(vget_low_s16(data), vget_low_s16(data));
+        auto hi = vmull_high_s16(data, data);
+        sum = vpadalq_u32(sum, vreinterpretq_u32_s32(lo));
+        sum = vpadalq_u32(sum, vreinterpretq_u32_s32(hi));
+    }
+    return vaddvq_u64(sum) + getenergyscalar(samples.subspan(pos));
+}
+
+static uint32_t crossingsneon(std::span<const int16_t> samples)
+{
+    uint32_t crossings{};
+    size_t pos{};
+    for (; pos + 9 <= samples.size(); pos += 8)
+    {
+        auto data = vld1q_s16(samples.data() + pos);
+        auto next = vld1q_s16(samples.data() + pos + 1);
+        auto signs = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(data, next)),
+                                 15);
+        crossings += vaddvq_u16(signs);
+    }
+    return crossings + getzerocrossingsscalar(samples.subspan(pos));
+}
+
+static std::pair<energy_t, crossings_t> getkernels()
+{
+    return {energyneon, crossingsneon};
+}
+#else
+static std::pair<energy_t, crossings_t> getkernels()
+{
+    return {getenergyscalar, getzerocrossingsscalar};
+}
+#endif
+
+uint64_t getenergy(std::span<const int16_t> samples)
+{
+    static const auto energy = getkernels().first;
+    return energy(samples);
+}
+
+uint32_t getzerocrossings(std::span<const int16_t> samples)
+{
+    static const auto crossings = getkernels().second;
+    return crossings(samples);
+}
+
+vadconfig_t getvadconfig(endpointing mode)
+{
+    using std::chrono::milliseconds;
+    switch (mode)
+    {
+        case endpointing::fast:
+            return {milliseconds{200}, milliseconds{40}, milliseconds{300},
+                    5.0, 0.05};
+        case endpointing::balanced:
+            return {};
+        case endpointing::accurate:
+            return {milliseconds{500}, milliseconds{100}, milliseconds{1200},
+                    3.0, 0.01};
+    }
+    return {};
+}
+
+static size_t getframes(std::chrono::milliseconds duration)
+{
+    return std::max<size_t>(
+        1, (size_t)duration.count() * sampleRate / 1000 / frameSize);
+}
+
+Endpointer::Endpointer(const vadconfig_t& config) :
+    config{config}, onsetframes{getframes(config.onset)},
+    trailingframes{getframes(config.trailing)},
+    prerollsize{(getframes(config.preroll) + onsetframes) * frameSize}
+{
+    frame.reserve(frameSize);
+}
+
+vadevent Endpointer::process(std::span<const int16_t> samples,
+                             std::vector<int16_t>& output)
+{
+    auto result{vadevent::none};
+    while (!samples.empty() && current != state::ended)
+    {
+        auto size = std::min(samples.size(), frameSize - frame.size());
+        frame.insert(frame.end(), samples.begin(),
+                     samples.begin() + (std::ptrdiff_t)size);
+        samples = samples.subspan(size);
+        if (frame.size() < frameSize)
+            break;
+        if (auto event = processframe(output); event != vadevent::none)
+            result = event;
+        frame.clear();
+    }
+    return result;
+}
+
+void Endpointer::reset()
+{
+    current = state::silence;
+    frame.clear();
+    preroll.clear();
+    speechframes = silentframes = 0;
+}
+
+bool Endpointer::isspeaking() const
+{
+    return current == state::speech;
+}
+
+double Endpointer::getnoisefloor() const
+{
+    return noisefloor;
+}
+
+vadevent Endpointer::processframe(std::vector<int16_t>& output)
+{
+    auto energy = (double)getenergy(frame) / frameSize;
+    auto speech = isspeech(energy, getzerocrossings(frame));
+    if (!speech)
+    {
+        auto rate = energy < noisefloor || noisefloor == 0
+                        ? 1.0
+                        : config.adaptation;
+        noisefloor = std::max(minNoiseFloor,
+                              noisefloor + (energy - noisefloor) * rate);
+    }
+
+    if (current == state::silence)
+    {
+        preroll.insert(preroll.end(), frame.begin(), frame.end());
+        while (preroll.size() > prerollsize)
+            preroll.pop_front();
+        speechframes = speech ? speechframes + 1 : 0;
+        if (speechframes < onsetframes)
+            return vadevent::none;
+        output.insert(output.end(), preroll.begin(), preroll.end());
+        preroll.clear();
+        current = state::speech;
+        silentframes = 0;
+        return vadevent::started;
+    }
+
+    output.insert(output.end(), frame.begin(), frame.end());
+    silentframes = speech ? 0 : silentframes + 1;
+    if (silentframes < trailingframes)
+        return vadevent::none;
+    current = state::ended;
+    return vadevent::ended;
+}
+
+// voiced speech is loud, unvoiced fricatives are quieter but cross zero
+// much more often than low frequency background hum
+bool Endpointer::isspeech(double energy, uint32_t crossings) const
+{
+    if (noisefloor == 0)
+        return false;
+    if (energy > noisefloor * config.threshold)
+        return true;
+    return energy > noisefloor * std::sqrt(config.threshold) &&
+           crossings > fricativeRate * frameSize;
+}
+
+} // namespace stt::capture
@@ -0,0 +1,218 @@
+#include "speech/threadpool.hpp"
+
+#include <algorithm>
+
+namespace speech::helpers
+{
+
+// workers mostly wait for network, so there are more of them than cores
+static const size_t defaultWorkers =
+    std::max<size_t>(8, 2 * std::thread::hardware_concurrency());
+
+// pool and queue of worker running on this thread, if any
+static thread_local const ThreadPool* currentPool{};
+static thread_local size_t currentQueue{};
+
+// tasks of older generation were cancelled, they are skipped once popped
+struct GroupState
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t queued{};
+    size_t running{};
+    uint64_t generation{};
+};
+
+ThreadPool::ThreadPool(size_t size)
+{
+    size = std::max<size_t>(size, 1);
+    for (size_t index{}; index < size; index++)
+        queues.push_back(std::make_unique<Queue>());
+    for (size_t index{}; index < size; index++)
+        workers.emplace_back(&ThreadPool::run, this, index);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mtx);
+        running = false;
+    }
+    cv.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+size_t ThreadPool::getworkers() const
+{
+    return workers.size();
+}
+
+poolstats_t ThreadPool::getstats() const
+{
+    return {executed, stolen, cancelled, inlined};
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::getdefault()
+{
+    static const auto pool = std::make_shared<ThreadPool>(defaultWorkers);
+    return pool;
+}
+
+void ThreadPool::push(Task&& task)
+{
+    if (currentPool == this)
+    {
+        auto& queue = *queues[currentQueue];
+        std::lock_guard lock(queue.mtx);
+        queue.tasks.push_front(std::move(task));
+    }
+    else
+    {
+        auto& queue = *queues[next++ % queues.size()];
+        std::lock_guard lock(queue.mtx);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(mtx);
+        pending++;
+    }
+    cv.notify_one();
+}
+
+// own queue is used from front, others are robbed from back, so owner and
+// thief rarely contend for same end
+bool ThreadPool::pop(size_t index, Task& task)
+{
+    for (size_t offset{}; offset < queues.size(); offset++)
+    {
+        auto& queue = *queues[(index + offset) % queues.size()];
+        std::lock_guard lock(queue.mtx);
+        if (queue.tasks.empty())
+            continue;
+        if (offset == 0)
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            stolen++;
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index)
+{
+    currentPool = this;
+    currentQueue = index;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [this]() { return !running || pending > 0; });
+            if (pending == 0)
+                return;
+            pending--;
+        }
+        // task counted is already in some queue, it may only be taken by
+        // other worker that counted another one, so search is retried
+        Task task;
+        while (!pop(index, task))
+            std::this_thread::yield();
+        execute(task);
+    }
+}
+
+void ThreadPool::execute(Task& task)
+{
+    auto& group = *task.group;
+    {
+        std::lock_guard lock(group.mtx);
+        if (task.generation != group.generation)
+        {
+            cancelled++;
+            return;
+        }
+        group.queued--;
+        group.running++;
+    }
+    try
+    {
+        task.func();
+    }
+    catch (...)
+    {
+        // fire and forget task has no one to report to, async result
+        // carries its exception in future
+    }
+    // captured state is released before owner may learn group is idle
+    task.func = nullptr;
+    executed++;
+    {
+        std::lock_guard lock(group.mtx);
+        group.running--;
+    }
+    group.cv.notify_all();
+}
+
+TaskGroup::TaskGroup(std::shared_ptr<ThreadPool> pool, size_t capacity) :
+    pool{pool}, capacity{std::max<size_t>(capacity, 1)},
+    state{std::make_shared<GroupState>()}
+{}
+
+TaskGroup::~TaskGroup()
+{
+    cancel();
+    wait();
+}
+
+bool TaskGroup::submit(std::function<void()>&& func)
+{
+    uint64_t generation{};
+    {
+        std::lock_guard lock(state->mtx);
+        if (state->queued + state->running >= capacity)
+            return false;
+        state->queued++;
+        generation = state->generation;
+    }
+    pool->push({std::move(func), state, generation});
+    return true;
+}
+
+bool TaskGroup::wait()
+{
+    std::unique_lock lock(state->mtx);
+    if (state->queued == 0 && state->running == 0)
+        return false;
+    state->cv.wait(lock, [this]() {
+        return state->queued == 0 && state->running == 0;
+    });
+    return true;
+}
+
+bool TaskGroup::cancel()
+{
+    bool pending{};
+    {
+        std::lock_guard lock(state->mtx);
+        pending = state->queued > 0 || state->running > 0;
+        state->generation++;
+        state->queued = 0;
+    }
+    state->cv.notify_all();
+    return pending;
+}
+
+size_t TaskGroup::getpending() const
+{
+    std::lock_guard lock(state->mtx);
+    return state->queued + state->running;
+}
+
+} // namespace speech::helpers
@@ -0,0 +1,88 @@
+#include "speech/tts/audiocache.hpp"
+
+#include <cctype>
+
+namespace tts
+{
+
+// text is trimmed and has whitespace collapsed, so trivially different
+// spellings of same prompt share one entry
+std::string getcachekey(const audiokey_t& key)
+{
+    const auto& [text, voice, encoding] = key;
+    std::string normalized;
+    normalized.reserve(text.size() + voice.size() + encoding.size() + 2);
+    for (bool space{false}; auto sign : text)
+    {
+        if (std::isspace((unsigned char)sign))
+        {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space)
+            normalized.push_back(' ');
+        normalized.push_back(sign);
+        space = false;
+    }
+    return normalized + '\0' + voice + '\0' + encoding;
+}
+
+AudioCache::AudioCache(size_t budget) : budget{budget}
+{}
+
+audio_t AudioCache::get(const audiokey_t& key)
+{
+    std::lock_guard lock(mtx);
+    if (auto it = index.find(getcachekey(key)); it != index.end())
+    {
+        entries.splice(entries.begin(), entries, it->second);
+        stats.hits++;
+        return it->second->second;
+    }
+    stats.misses++;
+    return nullptr;
+}
+
+audio_t AudioCache::put(const audiokey_t& key, std::string&& data)
+{
+    auto audio = std::make_shared<const std::string>(std::move(data));
+    if (audio->size() > budget)
+        return audio;
+
+    auto cachekey = getcachekey(key);
+    std::lock_guard lock(mtx);
+    if (auto it = index.find(cachekey); it != index.end())
+    {
+        stats.bytes -= it->second->second->size();
+        entries.erase(it->second);
+        index.erase(it);
+        stats.entries--;
+    }
+    evict(audio->size());
+    entries.emplace_front(cachekey, audio);
+    index.emplace(std::move(cachekey), entries.begin());
+    stats.entries++;
+    stats.bytes += audio->size();
+    return audio;
+}
+
+cachestats_t AudioCache::getstats() const
+{
+    std::lock_guard lock(mtx);
+    return stats;
+}
+
+void AudioCache::evict(size_t needed)
+{
+    while (!entries.empty() && stats.bytes + needed > budget)
+    {
+        const auto& [cachekey, audio] = entries.back();
+        stats.bytes -= audio->size();
+        index.erase(cachekey);
+        entries.pop_back();
+        stats.entries--;
+        stats.evictions++;
+    }
+}
+
+} // namespace tts
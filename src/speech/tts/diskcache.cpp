@@ -0,0 +1,214 @@
+#include "speech/tts/diskcache.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace tts
+{
+
+using namespace std::chrono_literals;
+
+static constexpr auto evictionInterval{60s};
+static const std::map<std::string, std::string> extensionMap = {
+    {"MP3", ".mp3"}, {"LINEAR16", ".wav"}, {"OGG_OPUS", ".ogg"}};
+
+// 64-bit fnv-1a, stable between runs and builds unlike std::hash
+static uint64_t gethash(std::string_view data)
+{
+    uint64_t hash{0xcbf29ce484222325};
+    for (auto sign : data)
+    {
+        hash ^= (uint8_t)sign;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+DiskCache::DiskCache(const std::filesystem::path& directory, uint64_t budget) :
+    directory{directory}, budget{budget}
+{
+    std::filesystem::create_directories(directory);
+    evictor = std::thread(&DiskCache::runevictor, this);
+}
+
+DiskCache::~DiskCache()
+{
+    {
+        std::lock_guard lock(mtx);
+        running = false;
+    }
+    cv.notify_all();
+    evictor.join();
+}
+
+std::optional<std::filesystem::path> DiskCache::get(const audiokey_t& key)
+{
+    auto path = getpath(key);
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec))
+    {
+        // access time is kept in modification time, oldest evicted first
+        std::filesystem::last_write_time(
+            path, std::filesystem::file_time_type::clock::now(), ec);
+        std::lock_guard lock(mtx);
+        stats.hits++;
+        return path;
+    }
+    std::lock_guard lock(mtx);
+    stats.misses++;
+    return std::nullopt;
+}
+
+std::optional<std::filesystem::path> DiskCache::put(const audiokey_t& key,
+                                                    std::string_view audio)
+{
+    auto path = getpath(key);
+    auto temppath = gettemppath(path);
+    std::ofstream ofs(temppath, std::ios::binary);
+    ofs.write(audio.data(), (std::streamsize)audio.size());
+    ofs.close();
+    if (ofs)
+        return commit(temppath, path);
+    std::error_code ec;
+    std::filesystem::remove(temppath, ec);
+    return std::nullopt;
+}
+
+std::optional<std::filesystem::path>
+    DiskCache::putfile(const audiokey_t& key, const std::filesystem::path& file)
+{
+    auto path = getpath(key);
+    auto temppath = gettemppath(path);
+    std::error_code ec;
+    // file is moved into cache, copied only if on other filesystem
+    std::filesystem::rename(file, temppath, ec);
+    if (ec && (!std::filesystem::copy_file(file, temppath, ec) ||
+               !std::filesystem::remove(file, ec)))
+    {
+        std::filesystem::remove(temppath, ec);
+        return std::nullopt;
+    }
+    return commit(temppath, path);
+}
+
+cachestats_t DiskCache::getstats() const
+{
+    std::lock_guard lock(mtx);
+    return stats;
+}
+
+std::filesystem::path DiskCache::getpath(const audiokey_t& key) const
+{
+    char name[17]{};
+    snprintf(name, sizeof(name), "%016llx",
+             (unsigned long long)gethash(getcachekey(key)));
+    const auto& encoding = std::get<2>(key);
+    auto extension = extensionMap.contains(encoding)
+                         ? extensionMap.at(encoding)
+                         : ".raw";
+    return directory / (name + extension);
+}
+
+std::filesystem::path
+    DiskCache::gettemppath(const std::filesystem::path& path) const
+{
+    static std::atomic<uint64_t> counter;
+    return path.native() + ".tmp." + std::to_string(getpid()) + "." +
+           std::to_string(counter++);
+}
+
+// rename within same directory is atomic, readers never see partial file
+std::optional<std::filesystem::path>
+    DiskCache::commit(const std::filesystem::path& temppath,
+                      const std::filesystem::path& path)
+{
+    std::error_code ec;
+    auto size = std::filesystem::file_size(temppath, ec);
+    auto replaced = std::filesystem::exists(path, ec);
+    std::filesystem::rename(temppath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temppath, ec);
+        return std::nullopt;
+    }
+    {
+        std::lock_guard lock(mtx);
+        stats.entries += replaced ? 0 : 1;
+        stats.bytes += replaced ? 0 : size;
+        evictneeded = stats.bytes > budget;
+    }
+    cv.notify_all();
+    return path;
+}
+
+void DiskCache::runevictor()
+{
+    std::unique_lock lock(mtx);
+    while (running)
+    {
+        if (evictneeded)
+        {
+            evictneeded = false;
+            lock.unlock();
+            evict();
+            lock.lock();
+            continue;
+        }
+        cv.wait_for(lock, evictionInterval,
+                    [this]() { return !running || evictneeded; });
+        // periodic rescan also picks up files changed by other processes
+        evictneeded = running;
+    }
+}
+
+void DiskCache::evict()
+{
+    using entry_t =
+        std::tuple<std::filesystem::file_time_type, uint64_t,
+                   std::filesystem::path>;
+    std::vector<entry_t> entries;
+    uint64_t bytes{};
+    std::error_code ec;
+    for (const auto& file :
+         std::filesystem::directory_iterator(directory, ec))
+    {
+        if (!file.is_regular_file(ec))
+            continue;
+        auto size = file.file_size(ec);
+        auto time = file.last_write_time(ec);
+        if (!ec)
+        {
+            entries.emplace_back(time, size, file.path());
+            bytes += size;
+        }
+    }
+
+    uint64_t evicted{};
+    if (bytes > budget)
+    {
+        std::ranges::sort(entries);
+        for (const auto& [time, size, path] : entries)
+        {
+            if (bytes <= budget)
+                break;
+            if (std::filesystem::remove(path, ec))
+            {
+                bytes -= size;
+                evicted++;
+            }
+        }
+    }
+
+    std::lock_guard lock(mtx);
+    stats.entries = entries.size() - evicted;
+    stats.bytes = bytes;
+    stats.evictions += evicted;
+}
+
+} // namespace tts
@@ -1,14 +1,19 @@
 #include "speech/tts/interfaces/googleapi.hpp"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/base64.hpp"
+#include "speech/cancel.hpp"
 #include "speech/helpers.hpp"
+#include "speech/tts/pipeline.hpp"
 
-#include <boost/beast/core/detail/base64.hpp>
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <cctype>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <map>
 #include <mutex>
 #include <source_location>
@@ -21,13 +26,9 @@ using namespace std::string_literals;
 using json = nlohmann::json;
 
 static const std::filesystem::path configFile = "../conf/init.json";
-static const std::filesystem::path audioDirectory = "audio";
-static const std::filesystem::path playbackName = "playback.mp3";
-static const std::string playAudioCmd =
-    "play --no-show-progress " + (audioDirectory / playbackName).native() +
-    " --type alsa";
 static const std::string convUri =
     "https://texttospeech.googleapis.com/v1/text:synthesize";
+static const std::string audioEncoding = "MP3";
 
 static const std::map<voice_t,
                       std::tuple<std::string, std::string, std::string>>
@@ -50,6 +51,132 @@ static const std::map<voice_t,
                 {{language::german, gender::male, 1},
                  {"de-DE", "de-DE-Standard-B", "MALE"}}};
 
+// picks audioContent out of synthesize response while it is received and
+// decodes it on the fly, so neither response nor encoded audio is stored
+class AudioContentParser
+{
+  public:
+    explicit AudioContentParser(std::string& audio) : audio{audio}
+    {}
+
+    bool parse(std::string_view chunk)
+    {
+        while (!chunk.empty())
+        {
+            switch (stage)
+            {
+                case stage_t::key:
+                    if (!findkey(chunk))
+                        return false;
+                    break;
+                case stage_t::colon:
+                case stage_t::quote:
+                    if (std::isspace((uint8_t)chunk.front()) == 0)
+                    {
+                        if (chunk.front() != (stage == stage_t::colon ? ':'
+                                                                      : '"'))
+                            return false;
+                        stage = stage == stage_t::colon ? stage_t::quote
+                                                        : stage_t::content;
+                    }
+                    chunk.remove_prefix(1);
+                    break;
+                case stage_t::content:
+                    if (!decodecontent(chunk))
+                        return false;
+                    break;
+                case stage_t::done:
+                    return true;
+            }
+        }
+        return true;
+    }
+
+    bool iscomplete() const
+    {
+        return stage == stage_t::done;
+    }
+
+    const std::string& getresponse() const
+    {
+        return head;
+    }
+
+  private:
+    static constexpr std::string_view contentKey{"\"audioContent\""};
+    // bounds part of response kept while looking for content, error
+    // responses come without content and are reported from it
+    static constexpr size_t headLimit{4096};
+    enum class stage_t
+    {
+        key,
+        colon,
+        quote,
+        content,
+        done
+    } stage{stage_t::key};
+    std::string& audio;
+    base64::StreamDecoder decoder;
+    std::string head;
+    bool escaped{false};
+
+    bool findkey(std::string_view& chunk)
+    {
+        const auto previous = head.size();
+        const auto appended = std::min(chunk.size(), headLimit - previous);
+        if (appended == 0)
+            return false;
+        head.append(chunk.substr(0, appended));
+        const auto from = previous >= contentKey.size()
+                              ? previous - contentKey.size() + 1
+                              : 0;
+        if (auto pos = head.find(contentKey, from); pos != std::string::npos)
+        {
+            chunk.remove_prefix(pos + contentKey.size() - previous);
+            stage = stage_t::colon;
+        }
+        else
+            chunk.remove_prefix(appended);
+        return true;
+    }
+
+    bool decodecontent(std::string_view& chunk)
+    {
+        if (escaped)
+        {
+            escaped = false;
+            if (!decoder.decode(chunk.substr(0, 1), audio))
+                return false;
+            chunk.remove_prefix(1);
+            return true;
+        }
+        auto end = std::min(chunk.find_first_of("\"\\"), chunk.size());
+        if (!decoder.decode(chunk.substr(0, end), audio))
+            return false;
+        chunk.remove_prefix(end);
+        if (!chunk.empty())
+        {
+            if (chunk.front() == '"')
+            {
+                if (!decoder.finish(audio))
+                    return false;
+                stage = stage_t::done;
+            }
+            escaped = chunk.front() == '\\';
+            chunk.remove_prefix(1);
+        }
+        return true;
+    }
+};
+
+// segment synthesized by curl multi engine, owned by its transfer
+struct Synthesis
+{
+    std::string audio;
+    AudioContentParser parser{audio};
+    std::promise<segment_t> segment;
+};
+
 struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
 {
   public:
@@ -57,7 +184,6 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
         shell{shell::Factory::create<shell::lnx::bash::Shell>()},
         helpers{speech::helpers::HelpersFactory::create()},
-        filesystem{this, audioDirectory / playbackName},
         google{this, configFile, std::get<voice_t>(config)}
     {}
 
@@ -65,67 +191,85 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
         shell{std::get<std::shared_ptr<shell::ShellIf>>(config)},
         helpers{std::get<std::shared_ptr<speech::helpers::HelpersIf>>(config)},
-        filesystem{this, audioDirectory / playbackName},
+        google{this, configFile, std::get<voice_t>(config)}
+    {}
+
+    explicit Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        helpers{speech::helpers::HelpersFactory::create()},
+        options{std::get<options_t>(config)},
         google{this, configFile, std::get<voice_t>(config)}
     {}
 
     bool speak(const std::string& text)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            auto audio = google.getaudio(text);
-            filesystem.savetofile(audio);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text).get().spoken;
     }
 
     bool speak(const std::string& text, const voice_t& voice)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            auto audio = google.getaudio(text, voice);
-            filesystem.savetofile(audio);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text, voice).get().spoken;
     }
 
-    bool speakasync(const std::string& text)
+    speakhandle_t enqueue(const std::string& text)
+    {
+        return enqueue(text, google.getvoice());
+    }
+
+    speakhandle_t enqueue(const std::string& text, const voice_t& voice)
     {
-        return helpers->createasync([weak = weak_from_this(), text]() {
-            if (auto self = weak.lock())
-                self->speak(text);
+        log(logs::level::debug, "Queued text to speak: '" + text + "'");
+        // token is taken now, so cancel reaches utterance still in queue
+        return queue.push([this, text, voice, token = canceller.gettoken()]() {
+            return play(text, voice, token);
         });
     }
 
+    bool speakasync(const std::string& text)
+    {
+        return Pipeline::isaccepted(enqueue(text));
+    }
+
     bool speakasync(const std::string& text, const voice_t& voice)
     {
-        return helpers->createasync([weak = weak_from_this(), text, voice]() {
-            if (auto self = weak.lock())
-                self->speak(text, voice);
+        return Pipeline::isaccepted(enqueue(text, voice));
+    }
+
+    bool waitspoken()
+    {
+        return queue.wait();
+    }
+
+    audio_t synthesize(const std::string& text)
+    {
+        return synthesize(text, google.getvoice());
+    }
+
+    audio_t synthesize(const std::string& text, const voice_t& voice)
+    {
+        return getaudio(getkey(text, voice), [this, &text, &voice]() {
+            return google.getaudio(text, voice,
+                                   canceller.gettoken(options.timeout));
         });
     }
 
-    bool waitspoken() const
+    bool cancel()
     {
-        return helpers->waitasync();
+        // utterances in queue are dropped first, so none starts meanwhile
+        auto pending = queue.cancel();
+        pending = canceller.cancel() || pending;
+        pipeline.cancel();
+        log(logs::level::debug, "Speech cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+        return pending;
     }
 
     void setvoice(const voice_t& voice)
     {
         google.setvoice(voice);
-        log(logs::level::debug, "Setting voice to: " + google.getparams());
+        log(logs::level::debug,
+            "Setting voice to: " + google.getparams(voice));
     }
 
     voice_t getvoice() const
@@ -137,60 +281,7 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
     const std::shared_ptr<logs::LogIf> logif;
     const std::shared_ptr<shell::ShellIf> shell;
     const std::shared_ptr<speech::helpers::HelpersIf> helpers;
-    std::mutex mtx;
-    class Filesystem
-    {
-      public:
-        Filesystem(const Handler* handler, const std::filesystem::path& path) :
-            handler{handler}, path{path}
-        {
-            createdirectory();
-        }
-
-        ~Filesystem()
-        {
-            removedirectory();
-        }
-
-        void createdirectory()
-        {
-            if ((direxist =
-                     !std::filesystem::create_directories(path.parent_path())))
-                handler->log(logs::level::warning,
-                             "Cannot create already existing directory: '" +
-                                 path.parent_path().native() + "'");
-            else
-                handler->log(logs::level::debug,
-                             "Created directory: '" +
-                                 path.parent_path().native() + "'");
-        }
-        void removedirectory() const
-        {
-            direxist ? false : std::filesystem::remove_all(path.parent_path());
-            if (direxist)
-                handler->log(logs::level::warning,
-                             "Not removing previously existed directory: '" +
-                                 path.parent_path().native() + "'");
-            else
-                handler->log(logs::level::debug,
-                             "Removed directory: '" +
-                                 path.parent_path().native() + "'");
-        }
-
-        void savetofile(const std::string& data) const
-        {
-            std::ofstream ofs(path, std::ios::binary);
-            ofs << data;
-            handler->log(logs::level::debug,
-                         "Written data of size: " + str(data.size()) +
-                             ", to file: '" + path.native() + "'");
-        }
-
-      private:
-        const Handler* handler;
-        const std::filesystem::path path;
-        bool direxist;
-    } filesystem;
+    const options_t options;
     class Google
     {
       public:
@@ -223,68 +314,188 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                              getparams());
         }
 
-        std::string getaudio(const std::string& text)
+        // request is built per call from read-only voice table and url,
+        // so any number of syntheses may run at once
+        std::string getaudio(const std::string& text, const voice_t& voice,
+                             std::shared_ptr<CancelToken> token) const
         {
-            const auto& [code, name, gender] = getmappedvoice();
-            const std::string config =
-                "{'input':{'text':'" + text + "'},'voice':{'languageCode':'" +
-                code + "','name':'" + name + "','ssmlGender':'" + gender +
-                "'},'audioConfig':{'audioEncoding':'MP3'}}";
-            std::string audioData;
-            handler->helpers->uploadData(audiourl, config, audioData);
-            auto rawaudio = json::parse(std::move(audioData))["audioContent"]
-                                .get<std::string>();
-            return decode(rawaudio);
+            // transfer is aborted with token or once its deadline passes
+            CancelScope scope{token};
+            const auto config = getrequest(text, voice);
+            std::string audio;
+            AudioContentParser parser{audio};
+            handler->helpers->uploadData(
+                audiourl, config,
+                [&parser](std::string_view chunk) {
+                    return parser.parse(chunk);
+                });
+            if (!parser.iscomplete())
+                throw std::runtime_error("Cannot get TTS audio content: " +
+                                         parser.getresponse());
+            handler->log(logs::level::debug,
+                         "Text synthesized as " + getparams(voice));
+            return audio;
         }
 
-        std::string getaudio(const std::string& text, const voice_t& tmpvoice)
+        // same synthesis run by curl multi engine, response is parsed as
+        // received and outcome is left to completion
+        void getaudio(const std::string& text, const voice_t& voice,
+                      std::shared_ptr<CancelToken> token,
+                      std::shared_ptr<Synthesis> synthesis,
+                      completion_t complete) const
         {
-            const auto mainVoice{voice};
-            voice = tmpvoice;
-            auto audio = getaudio(text);
-            handler->log(logs::level::debug, "Text spoken as " + getparams());
-            voice = mainVoice;
-            return audio;
+            CancelScope scope{token};
+            handler->helpers->uploadDataAsync(
+                audiourl, getrequest(text, voice),
+                [synthesis](std::string_view chunk) {
+                    return synthesis->parser.parse(chunk);
+                },
+                std::move(complete));
         }
 
         voice_t getvoice() const
         {
+            std::lock_guard lock{mtx};
             return voice;
         }
 
         void setvoice(const voice_t& voice)
         {
+            std::lock_guard lock{mtx};
             this->voice = voice;
         }
 
         std::string getparams() const
         {
-            const auto& [code, name, gender] = getmappedvoice();
+            return getparams(getvoice());
+        }
+
+        std::string getparams(const voice_t& voice) const
+        {
+            const auto& [code, name, gender] = getmappedvoice(voice);
             return code + "/" + name + "/" + gender;
         }
 
       private:
         const Handler* handler;
         const std::string audiourl;
+        // default voice only, requests never share mutable state
+        mutable std::mutex mtx;
         voice_t voice;
 
-        decltype(voiceMap)::mapped_type getmappedvoice() const
+        // text is escaped by serializer, so quotes cannot break request
+        static std::string getrequest(const std::string& text,
+                                      const voice_t& voice)
+        {
+            const auto& [code, name, gender] = getmappedvoice(voice);
+            return json{{"input", {{"text", text}}},
+                        {"voice",
+                         {{"languageCode", code},
+                          {"name", name},
+                          {"ssmlGender", gender}}},
+                        {"audioConfig", {{"audioEncoding", audioEncoding}}}}
+                .dump();
+        }
+
+        static decltype(voiceMap)::mapped_type
+            getmappedvoice(const voice_t& voice)
         {
-            decltype(voice) defaultvoice = {std::get<language>(voice),
-                                            std::get<gender>(voice), 1};
+            voice_t defaultvoice = {std::get<language>(voice),
+                                    std::get<gender>(voice), 1};
             return voiceMap.contains(voice) ? voiceMap.at(voice)
                                             : voiceMap.at(defaultvoice);
         }
+    } google;
+    Canceller canceller;
+    const std::shared_ptr<playback::Player> player{getplayer(options)};
+    Pipeline pipeline{logif, shell, player, options.synthesizeahead};
+    // declared last, so worker stops before anything it uses is released
+    SpeakQueue queue{options.queuesize, options.policy};
+
+    spoken_t play(const std::string& text, const voice_t& voice,
+                  std::shared_ptr<CancelToken> token)
+    {
+        return pipeline.play(
+            text,
+            [this, &voice](const std::string& sentence, size_t) {
+                return getplayback(sentence, voice);
+            },
+            token);
+    }
+
+    // segment not cached is synthesized by curl multi engine, taking no
+    // pool thread; its completion owns all it uses, as utterance may be
+    // abandoned and handler released before transfer ends
+    Pipeline::synthesis_t getplayback(const std::string& text,
+                                      const voice_t& voice)
+    {
+        const auto key = getkey(text, voice);
+        auto synthesis = std::make_shared<Synthesis>();
+        auto segment = synthesis->segment.get_future();
+        if (options.diskcache)
+        {
+            if (auto file = options.diskcache->get(key))
+            {
+                log(logs::level::debug,
+                    "Using disk cached audio: '" + file->native() + "'");
+                synthesis->segment.set_value({file->native(), {}});
+                return segment;
+            }
+        }
+        if (auto audio = options.cache ? options.cache->get(key) : nullptr)
+        {
+            log(logs::level::debug, "Using cached audio of size: " +
+                                        str(audio->size()));
+            synthesis->segment.set_value({{}, audio});
+            return segment;
+        }
+        google.getaudio(
+            text, voice, canceller.gettoken(options.timeout), synthesis,
+            [synthesis, key, cache = options.cache,
+             diskcache = options.diskcache](bool done) {
+                if (!done || !synthesis->parser.iscomplete())
+                {
+                    synthesis->segment.set_exception(
+                        std::make_exception_ptr(std::runtime_error(
+                            "Cannot get TTS audio content: " +
+                            synthesis->parser.getresponse())));
+                    return;
+                }
+                auto& received = synthesis->audio;
+                auto audio = cache ? cache->put(key, std::move(received))
+                                   : std::make_shared<const std::string>(
+                                         std::move(received));
+                if (diskcache)
+                {
+                    if (auto file = diskcache->put(key, *audio))
+                    {
+                        synthesis->segment.set_value({file->native(), {}});
+                        return;
+                    }
+                }
+                synthesis->segment.set_value({{}, audio});
+            });
+        return segment;
+    }
+
+    audiokey_t getkey(const std::string& text, const voice_t& voice) const
+    {
+        return {text, google.getparams(voice), audioEncoding};
+    }
 
-        std::string decode(const std::string& encoded)
+    audio_t getaudio(const audiokey_t& key,
+                     const std::function<std::string()>& synthesize)
+    {
+        if (!options.cache)
+            return std::make_shared<const std::string>(synthesize());
+        if (auto audio = options.cache->get(key))
         {
-            using namespace boost::beast::detail;
-            std::string decoded(encoded.size(), '\0');
-            // decoded.resize(base64::encoded_size(encoded.size()));
-            base64::decode(&decoded[0], encoded.c_str(), decoded.size());
-            return decoded;
+            log(logs::level::debug, "Using cached audio of size: " +
+                                        str(audio->size()));
+            return audio;
         }
-    } google;
+        return options.cache->put(key, synthesize());
+    }
 
     void log(
         logs::level level, const std::string& msg,
@@ -322,6 +533,17 @@ bool TextToVoice::speak(const std::string& text, const voice_t& voice)
     return handler->speak(text, voice);
 }
 
+speakhandle_t TextToVoice::enqueue(const std::string& text)
+{
+    return handler->enqueue(text);
+}
+
+speakhandle_t TextToVoice::enqueue(const std::string& text,
+                                   const voice_t& voice)
+{
+    return handler->enqueue(text, voice);
+}
+
 bool TextToVoice::speakasync(const std::string& text)
 {
     return handler->speakasync(text);
@@ -337,6 +559,16 @@ bool TextToVoice::waitspoken()
     return handler->waitspoken();
 }
 
+audio_t TextToVoice::synthesize(const std::string& text)
+{
+    return handler->synthesize(text);
+}
+
+audio_t TextToVoice::synthesize(const std::string& text, const voice_t& voice)
+{
+    return handler->synthesize(text, voice);
+}
+
 voice_t TextToVoice::getvoice()
 {
     return handler->getvoice();
@@ -347,4 +579,9 @@ void TextToVoice::setvoice(const voice_t& voice)
     handler->setvoice(voice);
 }
 
+bool TextToVoice::cancel()
+{
+    return handler->cancel();
+}
+
 } // namespace tts::googleapi
@@ -1,10 +1,15 @@
 #include "speech/tts/interfaces/googlebasic.hpp"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/cancel.hpp"
 #include "speech/helpers.hpp"
+#include "speech/tts/pipeline.hpp"
 
 #include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <map>
 #include <mutex>
 #include <source_location>
@@ -17,11 +22,9 @@ using namespace std::string_literals;
 
 static const std::filesystem::path audioDirectory = "audio";
 static const std::filesystem::path playbackName = "playback.mp3";
-static const std::string playAudioCmd =
-    "play --no-show-progress " + (audioDirectory / playbackName).native() +
-    " --type alsa";
 static constexpr const char* convUri =
     "https://translate.google.com/translate_tts?client=tw-ob";
+static const std::string audioEncoding = "MP3";
 
 static const std::map<voice_t, std::string> voiceMap = {
     {{language::polish, gender::male, 1}, "pl"},
@@ -39,7 +42,7 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         shell{shell::Factory::create<shell::lnx::bash::Shell>()},
         helpers{speech::helpers::HelpersFactory::create()},
         filesystem{this, audioDirectory / playbackName},
-        google{this, std::get<voice_t>(config), audioDirectory / playbackName}
+        google{this, std::get<voice_t>(config)}
     {}
 
     explicit Handler(const configall_t& config) :
@@ -47,65 +50,86 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         shell{std::get<std::shared_ptr<shell::ShellIf>>(config)},
         helpers{std::get<std::shared_ptr<speech::helpers::HelpersIf>>(config)},
         filesystem{this, audioDirectory / playbackName},
-        google{this, std::get<voice_t>(config), audioDirectory / playbackName}
+        google{this, std::get<voice_t>(config)}
+    {}
+
+    explicit Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        helpers{speech::helpers::HelpersFactory::create()},
+        options{std::get<options_t>(config)},
+        filesystem{this, audioDirectory / playbackName},
+        google{this, std::get<voice_t>(config)}
     {}
 
     bool speak(const std::string& text)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            google.getaudio(text);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text).get().spoken;
     }
 
     bool speak(const std::string& text, const voice_t& voice)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            google.getaudio(text, voice);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text, voice).get().spoken;
     }
 
-    bool speakasync(const std::string& text)
+    speakhandle_t enqueue(const std::string& text)
     {
-        return helpers->createasync([this, weak = weak_from_this(), text]() {
-            if (auto self = weak.lock())
-                self->speak(text);
+        return enqueue(text, google.getvoice());
+    }
+
+    speakhandle_t enqueue(const std::string& text, const voice_t& voice)
+    {
+        log(logs::level::debug, "Queued text to speak: '" + text + "'");
+        // token is taken now, so cancel reaches utterance still in queue
+        return queue.push([this, text, voice, token = canceller.gettoken()]() {
+            return play(text, voice, token);
         });
     }
 
+    bool speakasync(const std::string& text)
+    {
+        return Pipeline::isaccepted(enqueue(text));
+    }
+
     bool speakasync(const std::string& text, const voice_t& voice)
     {
-        return helpers->createasync(
-            [this, weak = weak_from_this(), text, voice]() {
-                if (auto self = weak.lock())
-                    self->speak(text, voice);
-            });
+        return Pipeline::isaccepted(enqueue(text, voice));
     }
 
-    bool waitspoken() const
+    bool waitspoken()
     {
-        return helpers->waitasync();
+        return queue.wait();
+    }
+
+    audio_t synthesize(const std::string& text)
+    {
+        return synthesize(text, google.getvoice());
+    }
+
+    audio_t synthesize(const std::string& text, const voice_t& voice)
+    {
+        return getaudio(getkey(text, voice), [this, &text, &voice]() {
+            return google.getaudio(text, voice,
+                                   canceller.gettoken(options.timeout));
+        });
+    }
+
+    bool cancel()
+    {
+        // utterances in queue are dropped first, so none starts meanwhile
+        auto pending = queue.cancel();
+        pending = canceller.cancel() || pending;
+        pipeline.cancel();
+        log(logs::level::debug, "Speech cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+        return pending;
     }
 
     void setvoice(const voice_t& voice)
     {
         google.setvoice(voice);
-        log(logs::level::debug, "Setting voice to: " + google.getparams());
+        log(logs::level::debug,
+            "Setting voice to: " + google.getparams(voice));
     }
 
     voice_t getvoice() const
@@ -117,7 +141,7 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
     const std::shared_ptr<logs::LogIf> logif;
     const std::shared_ptr<shell::ShellIf> shell;
     const std::shared_ptr<speech::helpers::HelpersIf> helpers;
-    std::mutex mtx;
+    const options_t options;
     class Filesystem
     {
       public:
@@ -158,6 +182,16 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                                  path.parent_path().native() + "'");
         }
 
+        std::filesystem::path getpath(size_t segment) const
+        {
+            if (segment == 0)
+                return path;
+            auto file{path};
+            return file.replace_filename(path.stem().native() + "-" +
+                                         str(segment) +
+                                         path.extension().native());
+        }
+
       private:
         const Handler* handler;
         const std::filesystem::path path;
@@ -167,11 +201,9 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
     class Google
     {
       public:
-        Google(const Handler* handler, const voice_t& voice,
-               const std::string& audiopath) :
-            handler{handler}, audiopath{audiopath}
+        Google(const Handler* handler, const voice_t& voice) :
+            handler{handler}, voice{voice}
         {
-            setvoice(voice);
             handler->log(logs::level::info,
                          "Created gbasic tts [lang/gender/idx]: " +
                              getparams());
@@ -184,43 +216,52 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                              getparams());
         }
 
-        void getaudio(const std::string& text)
+        // url is built per call from read-only voice table, so any number
+        // of syntheses may run at once; transfer is run by curl multi
+        // engine and its outcome is left to completion
+        void getaudio(const std::string& text, const voice_t& voice,
+                      const std::filesystem::path& audiopath,
+                      std::shared_ptr<CancelToken> token,
+                      completion_t complete) const
         {
-            handler->helpers->downloadFile(audiourl, text, audiopath);
+            // transfer is aborted with token or once its deadline passes
+            CancelScope scope{token};
+            handler->helpers->downloadFileAsync(geturl(voice), text, audiopath,
+                                                std::move(complete));
         }
 
-        void getaudio(const std::string& text, const voice_t& tmpvoice)
+        std::string getaudio(const std::string& text, const voice_t& voice,
+                             std::shared_ptr<CancelToken> token) const
         {
-            auto mainVoice{voice};
-            setvoice(tmpvoice);
-            getaudio(text);
-            handler->log(logs::level::debug, "Text spoken as " + getparams());
-            setvoice(mainVoice);
+            CancelScope scope{token};
+            std::string audio;
+            if (!handler->helpers->downloadData(geturl(voice), text, audio))
+                throw std::runtime_error("Cannot download TTS audio");
+            handler->log(logs::level::debug,
+                         "Text synthesized as " + getparams(voice));
+            return audio;
         }
 
         voice_t getvoice() const
         {
+            std::lock_guard lock{mtx};
             return voice;
         }
 
         void setvoice(const voice_t& voice)
         {
+            std::lock_guard lock{mtx};
             this->voice = voice;
-            decltype(voice) defaultvoice = {std::get<language>(voice),
-                                            std::get<gender>(voice), 1};
-            const auto& uselang = voiceMap.contains(voice)
-                                      ? voiceMap.at(voice)
-                                      : voiceMap.at(defaultvoice);
-            audiourl = std::string(convUri) + "&tl=" + uselang + "&q=";
         }
 
         std::string getparams() const
         {
-            decltype(voice) defaultvoice = {std::get<language>(voice),
-                                            std::get<gender>(voice), 1};
-            const auto& uselang = voiceMap.contains(voice)
-                                      ? voiceMap.at(voice)
-                                      : voiceMap.at(defaultvoice);
+            return getparams(getvoice());
+        }
+
+        std::string getparams(const voice_t& voice) const
+        {
+            const auto& uselang = getlang(voice);
             auto genderid = std::get<gender>(voice);
             return uselang + "/" +
                    std::string(genderid == gender::male     ? "male"
@@ -229,12 +270,123 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                    "/" + str(std::get<index>(voice));
         }
 
+        static const std::string& getlang(const voice_t& voice)
+        {
+            voice_t defaultvoice = {std::get<language>(voice),
+                                    std::get<gender>(voice), 1};
+            return voiceMap.contains(voice) ? voiceMap.at(voice)
+                                            : voiceMap.at(defaultvoice);
+        }
+
       private:
         const Handler* handler;
-        const std::string audiopath;
-        std::string audiourl;
+        // default voice only, requests never share mutable state
+        mutable std::mutex mtx;
         voice_t voice;
+
+        static std::string geturl(const voice_t& voice)
+        {
+            return std::string(convUri) + "&tl=" + getlang(voice) + "&q=";
+        }
     } google;
+    Canceller canceller;
+    const std::shared_ptr<playback::Player> player{getplayer(options)};
+    Pipeline pipeline{logif, shell, player, options.synthesizeahead};
+    // declared last, so worker stops before anything it uses is released
+    SpeakQueue queue{options.queuesize, options.policy};
+
+    spoken_t play(const std::string& text, const voice_t& voice,
+                  std::shared_ptr<CancelToken> token)
+    {
+        return pipeline.play(
+            text,
+            [this, &voice](const std::string& sentence, size_t segment) {
+                return getplayback(sentence, voice, segment);
+            },
+            token);
+    }
+
+    // audio downloaded straight to playback file by curl multi engine is
+    // moved to disk cache and kept in memory cache, on hit cached audio is
+    // played instead; completion owns all it uses, as utterance may be
+    // abandoned and handler released before transfer ends
+    Pipeline::synthesis_t getplayback(const std::string& text,
+                                      const voice_t& voice, size_t segment)
+    {
+        const auto key = getkey(text, voice);
+        auto ready = std::make_shared<std::promise<segment_t>>();
+        auto playback = ready->get_future();
+        if (options.diskcache)
+        {
+            if (auto file = options.diskcache->get(key))
+            {
+                log(logs::level::debug,
+                    "Using disk cached audio: '" + file->native() + "'");
+                ready->set_value({file->native(), {}});
+                return playback;
+            }
+        }
+        if (auto audio = options.cache ? options.cache->get(key) : nullptr)
+        {
+            log(logs::level::debug, "Using cached audio of size: " +
+                                        str(audio->size()));
+            ready->set_value({{}, audio});
+            return playback;
+        }
+        const auto file = filesystem.getpath(segment);
+        google.getaudio(
+            text, voice, file, canceller.gettoken(options.timeout),
+            [ready, key, file, cache = options.cache,
+             diskcache = options.diskcache](bool downloaded) {
+                // partial or failed download is never cached, so it is not
+                // served again later, also after restart
+                std::error_code ec;
+                if (!downloaded || std::filesystem::file_size(file, ec) == 0 ||
+                    ec)
+                {
+                    std::filesystem::remove(file, ec);
+                    ready->set_exception(std::make_exception_ptr(
+                        std::runtime_error("Cannot download TTS audio")));
+                    return;
+                }
+                if (cache)
+                {
+                    std::ifstream ifs(file, std::ios::binary);
+                    auto audio = std::string(
+                        std::istreambuf_iterator<char>(ifs.rdbuf()), {});
+                    cache->put(key, std::move(audio));
+                }
+                if (diskcache)
+                {
+                    if (auto cached = diskcache->putfile(key, file))
+                    {
+                        ready->set_value({cached->native(), {}});
+                        return;
+                    }
+                }
+                ready->set_value({file.native(), {}});
+            });
+        return playback;
+    }
+
+    audiokey_t getkey(const std::string& text, const voice_t& voice) const
+    {
+        return {text, google.getlang(voice), audioEncoding};
+    }
+
+    audio_t getaudio(const audiokey_t& key,
+                     const std::function<std::string()>& synthesize)
+    {
+        if (!options.cache)
+            return std::make_shared<const std::string>(synthesize());
+        if (auto audio = options.cache->get(key))
+        {
+            log(logs::level::debug, "Using cached audio of size: " +
+                                        str(audio->size()));
+            return audio;
+        }
+        return options.cache->put(key, synthesize());
+    }
 
     void log(
         logs::level level, const std::string& msg,
@@ -272,6 +424,17 @@ bool TextToVoice::speak(const std::string& text, const voice_t& voice)
     return handler->speak(text, voice);
 }
 
+speakhandle_t TextToVoice::enqueue(const std::string& text)
+{
+    return handler->enqueue(text);
+}
+
+speakhandle_t TextToVoice::enqueue(const std::string& text,
+                                   const voice_t& voice)
+{
+    return handler->enqueue(text, voice);
+}
+
 bool TextToVoice::speakasync(const std::string& text)
 {
     return handler->speakasync(text);
@@ -287,6 +450,16 @@ bool TextToVoice::waitspoken()
     return handler->waitspoken();
 }
 
+audio_t TextToVoice::synthesize(const std::string& text)
+{
+    return handler->synthesize(text);
+}
+
+audio_t TextToVoice::synthesize(const std::string& text, const voice_t& voice)
+{
+    return handler->synthesize(text, voice);
+}
+
 voice_t TextToVoice::getvoice()
 {
     return handler->getvoice();
@@ -297,4 +470,9 @@ void TextToVoice::setvoice(const voice_t& voice)
     handler->setvoice(voice);
 }
 
+bool TextToVoice::cancel()
+{
+    return handler->cancel();
+}
+
 } // namespace tts::googlebasic
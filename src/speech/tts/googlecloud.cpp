@@ -1,17 +1,27 @@
 #include "speech/tts/interfaces/googlecloud.hpp"
 
-#include "google/cloud/common_options.h"
-#include "google/cloud/credentials.h"
 #include "google/cloud/texttospeech/v1/text_to_speech_client.h"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/grpcoptions.hpp"
 #include "speech/helpers.hpp"
+#include "speech/threadpool.hpp"
+#include "speech/tts/pipeline.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <source_location>
 
 namespace tts::googlecloud
@@ -24,12 +34,17 @@ using namespace speech::helpers;
 using namespace std::string_literals;
 using ssmlgender = texttospeech::SsmlVoiceGender;
 
-static const std::filesystem::path keyFile = "../conf/key.json";
 static const std::filesystem::path audioDirectory = "audio";
 static const std::filesystem::path playbackName = "playback.mp3";
-static const std::string playAudioCmd =
-    "play --no-show-progress " + (audioDirectory / playbackName).native() +
-    " --type alsa";
+static constexpr auto audioEncoding = texttospeech::LINEAR16;
+// streamed audio is linear16 without wav header, its format is fixed here
+static constexpr auto streamEncoding = texttospeech::PCM;
+static constexpr uint32_t streamSampleRate{24000};
+// player returns once piece is written, so piece arriving this late after
+// previous one ended is not yet heard as gap
+static constexpr std::chrono::milliseconds underrunSlack{20};
+// streaming synthesis is served by chirp 3 hd voices only
+static const std::string streamVoiceFamily = "-Chirp3-HD-";
 // static constexpr const char* keyEnvVar = "GOOGLE_APPLICATION_CREDENTIALS";
 
 static const std::map<voice_t, std::tuple<std::string, std::string, ssmlgender>>
@@ -52,6 +67,21 @@ static const std::map<voice_t, std::tuple<std::string, std::string, ssmlgender>>
                 {{language::german, gender::male, 1},
                  {"de-DE", "de-DE-Standard-B", ssmlgender::MALE}}};
 
+static const std::map<ssmlgender, std::string> streamVoiceMap = {
+    {ssmlgender::FEMALE, "Kore"}, {ssmlgender::MALE, "Charon"}};
+
+// instances of same config share connection, only first one creates it
+static std::shared_ptr<texttospeech_type::TextToSpeechConnection>
+    getconnection(const connconfig_t& config)
+{
+    return Connections::getdefault()
+        ->get<texttospeech_type::TextToSpeechConnection>(
+            "texttospeech.v1", {}, config, [&config]() {
+                return texttospeech_type::MakeTextToSpeechConnection(
+                    getgrpcoptions(config));
+            });
+}
+
 struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
 {
   public:
@@ -60,7 +90,7 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         shell{shell::Factory::create<shell::lnx::bash::Shell>()},
         helpers{speech::helpers::HelpersFactory::create()},
         filesystem{this, audioDirectory / playbackName},
-        google{this, keyFile, std::get<voice_t>(config)}
+        google{this, std::get<voice_t>(config)}
     {}
 
     explicit Handler(const configall_t& config) :
@@ -68,66 +98,90 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         shell{std::get<std::shared_ptr<shell::ShellIf>>(config)},
         helpers{std::get<std::shared_ptr<speech::helpers::HelpersIf>>(config)},
         filesystem{this, audioDirectory / playbackName},
-        google{this, keyFile, std::get<voice_t>(config)}
+        google{this, std::get<voice_t>(config)}
     {}
 
+    explicit Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        helpers{speech::helpers::HelpersFactory::create()},
+        options{std::get<options_t>(config)},
+        filesystem{this, audioDirectory / playbackName},
+        google{this, std::get<voice_t>(config)}
+    {
+        if (options.streaming && options.externalplayer)
+            log(logs::level::warning,
+                "Streaming needs player, text is synthesized whole");
+    }
+
     bool speak(const std::string& text)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            auto audio = google.getaudio(text);
-            filesystem.savetofile(audio);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text).get().spoken;
     }
 
     bool speak(const std::string& text, const voice_t& voice)
     {
-        if (std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
-            lock.try_lock())
-        {
-            log(logs::level::debug, "Requested text to speak: '" + text + "'");
-            auto audio = google.getaudio(text, voice);
-            filesystem.savetofile(audio);
-            shell->run(playAudioCmd);
-            return true;
-        }
-        log(logs::level::warning,
-            "Cannot speak text: '" + text + "', tts in use");
-        return false;
+        return enqueue(text, voice).get().spoken;
     }
 
-    bool speakasync(const std::string& text)
+    speakhandle_t enqueue(const std::string& text)
     {
-        return helpers->createasync([weak = weak_from_this(), text]() {
-            if (auto self = weak.lock())
-                self->speak(text);
+        return enqueue(text, google.getvoice());
+    }
+
+    speakhandle_t enqueue(const std::string& text, const voice_t& voice)
+    {
+        log(logs::level::debug, "Queued text to speak: '" + text + "'");
+        // token is taken now, so cancel reaches utterance still in queue
+        return queue.push([this, text, voice, token = canceller.gettoken()]() {
+            return play(text, voice, token);
         });
     }
 
+    bool speakasync(const std::string& text)
+    {
+        return Pipeline::isaccepted(enqueue(text));
+    }
+
     bool speakasync(const std::string& text, const voice_t& voice)
     {
-        return helpers->createasync([weak = weak_from_this(), text, voice]() {
-            if (auto self = weak.lock())
-                self->speak(text, voice);
+        return Pipeline::isaccepted(enqueue(text, voice));
+    }
+
+    bool waitspoken()
+    {
+        return queue.wait();
+    }
+
+    audio_t synthesize(const std::string& text)
+    {
+        return synthesize(text, google.getvoice());
+    }
+
+    audio_t synthesize(const std::string& text, const voice_t& voice)
+    {
+        return getaudio(getkey(text, voice), [this, &text, &voice]() {
+            return google.getaudio(text, voice,
+                                   canceller.gettoken(options.timeout));
         });
     }
 
-    bool waitspoken() const
+    bool cancel()
     {
-        return helpers->waitasync();
+        // utterances in queue are dropped first, so none starts meanwhile
+        auto pending = queue.cancel();
+        pending = canceller.cancel() || pending;
+        pipeline.cancel();
+        log(logs::level::debug, "Speech cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+        return pending;
     }
 
     void setvoice(const voice_t& voice)
     {
         google.setvoice(voice);
-        log(logs::level::debug, "Setting voice to: " + google.getparams());
+        log(logs::level::debug,
+            "Setting voice to: " + google.getparams(voice));
     }
 
     voice_t getvoice() const
@@ -135,11 +189,20 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
         return google.getvoice();
     }
 
+    streamstats_t getstreamstats() const
+    {
+        std::lock_guard lock{streammtx};
+        auto stats{streamstats};
+        if (stats.streams > 0)
+            stats.firstaudio = firstaudiototal / stats.streams;
+        return stats;
+    }
+
   private:
     const std::shared_ptr<logs::LogIf> logif;
     const std::shared_ptr<shell::ShellIf> shell;
     const std::shared_ptr<speech::helpers::HelpersIf> helpers;
-    std::mutex mtx;
+    const options_t options;
     class Filesystem
     {
       public:
@@ -179,13 +242,24 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                                  path.parent_path().native() + "'");
         }
 
-        void savetofile(const std::string& data) const
+        void savetofile(const std::string& data, size_t segment) const
         {
-            std::ofstream ofs(path, std::ios::binary);
+            const auto file = getpath(segment);
+            std::ofstream ofs(file, std::ios::binary);
             ofs << data;
             handler->log(logs::level::debug,
                          "Written data of size: " + str(data.size()) +
-                             ", to file: '" + path.native() + "'");
+                             ", to file: '" + file.native() + "'");
+        }
+
+        std::filesystem::path getpath(size_t segment) const
+        {
+            if (segment == 0)
+                return path;
+            auto file{path};
+            return file.replace_filename(path.stem().native() + "-" +
+                                         str(segment) +
+                                         path.extension().native());
         }
 
       private:
@@ -196,25 +270,16 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
     class Google
     {
       public:
-        Google(const Handler* handler, const std::filesystem::path& keyfile,
-               const voice_t& voice) :
+        Google(const Handler* handler, const voice_t& voice) :
             handler{handler},
-            client{texttospeech_type::MakeTextToSpeechConnection(
-                google::cloud::Options{}
-                    .set<google::cloud::UnifiedCredentialsOption>(
-                        google::cloud::MakeServiceAccountCredentials(
-                            [](const std::filesystem::path& file) {
-                                std::ifstream ifs(file);
-                                if (!ifs.is_open())
-                                    throw std::runtime_error(
-                                        "Cannot open key file for TTS");
-                                return std::string(
-                                    std::istreambuf_iterator<char>(ifs.rdbuf()),
-                                    {});
-                            }(keyfile))))}
+            client{getconnection(handler->options.connection)},
+            audio{[]() {
+                texttospeech::AudioConfig audio;
+                audio.set_audio_encoding(audioEncoding);
+                return audio;
+            }()},
+            voice{voice}
         {
-            setvoice(voice);
-            audio.set_audio_encoding(texttospeech::LINEAR16);
             handler->log(logs::level::info,
                          "Created gcloud tts [langcode/langname/gender]: " +
                              getparams());
@@ -227,46 +292,103 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
                              getparams());
         }
 
-        std::string getaudio(const std::string& text)
+        // each call builds its own request from read-only voice table and
+        // audio config, client copies share connection and are safe to use
+        // concurrently, so any number of syntheses may run at once
+        // unary call cannot be interrupted safely through synchronous client,
+        // so it is bound by deadline only and abandoned by caller on cancel
+        std::string getaudio(const std::string& text, const voice_t& voice,
+                             std::shared_ptr<CancelToken> token) const
         {
-            input.set_text(text);
-            return client.SynthesizeSpeech(input, params, audio)
-                ->audio_content();
+            auto synthclient{client};
+            const auto input = getinput(text);
+            const auto params = getvoiceparams(voice);
+            auto response = synthclient.SynthesizeSpeech(
+                input, params, audio, getcalloptions(token));
+            if (!response)
+                throw std::runtime_error("Cannot synthesize text: " +
+                                         response.status().message());
+            handler->log(logs::level::debug,
+                         "Text synthesized as " + getparams(voice));
+            return std::move(*response->mutable_audio_content());
         }
 
-        std::string getaudio(const std::string& text, const voice_t& tmpvoice)
+        // text is sent sentence by sentence, so server starts on first one
+        // at once, and audio is handed over piece by piece as it arrives;
+        // stream is cancelled with token or when consumer refuses audio
+        bool streamaudio(const std::string& text, const voice_t& voice,
+                         const std::function<bool(std::string_view)>& consume,
+                         std::shared_ptr<CancelToken> request,
+                         const std::shared_ptr<CancelToken>& token) const
         {
-            const auto mainVoice{voice};
-            setvoice(tmpvoice);
-            auto response = getaudio(text);
-            handler->log(logs::level::debug, "Text spoken as " + getparams());
-            setvoice(mainVoice);
-            return response;
+            auto synthclient{client};
+            auto stream =
+                synthclient.AsyncStreamingSynthesize(getcalloptions(request));
+            // pending reads and writes complete at once, so loops below end
+            CancelCallback cancel{token, [&stream]() { stream->Cancel(); }};
+            texttospeech::StreamingSynthesizeRequest setup;
+            const auto& config = setup.mutable_streaming_config();
+            *config->mutable_voice() = getstreamvoiceparams(voice);
+            config->mutable_streaming_audio_config()->set_audio_encoding(
+                streamEncoding);
+            config->mutable_streaming_audio_config()->set_sample_rate_hertz(
+                (int)streamSampleRate);
+            bool sent = stream->Start().get() &&
+                        stream->Write(setup, grpc::WriteOptions{}).get();
+            for (const auto& sentence : splitsentences(text))
+            {
+                if (!sent)
+                    break;
+                texttospeech::StreamingSynthesizeRequest input;
+                input.mutable_input()->set_text(sentence);
+                sent = stream->Write(input, grpc::WriteOptions{}).get();
+            }
+            if (sent)
+                stream->WritesDone().get();
+
+            bool consumed{true};
+            while (auto response = stream->Read().get())
+            {
+                if (!(consumed = consume(response->audio_content())))
+                {
+                    stream->Cancel();
+                    break;
+                }
+            }
+            while (stream->Read().get())
+                ;
+            auto status = stream->Finish().get();
+            if (!status.ok() && consumed && !token->iscancelled())
+                handler->log(logs::level::error,
+                             "Streaming synthesis failed: " +
+                                 status.message());
+            else if (status.ok())
+                handler->log(logs::level::debug,
+                             "Text streamed as " + getparams(voice));
+            return consumed && status.ok();
         }
 
         voice_t getvoice() const
         {
+            std::lock_guard lock{mtx};
             return voice;
         }
 
         void setvoice(const voice_t& voice)
         {
+            std::lock_guard lock{mtx};
             this->voice = voice;
-            decltype(voice) defaultvoice = {std::get<language>(voice),
-                                            std::get<gender>(voice), 1};
-            const auto& [code, name, gender] = voiceMap.contains(voice)
-                                                   ? voiceMap.at(voice)
-                                                   : voiceMap.at(defaultvoice);
-
-            params.set_language_code(code);
-            params.set_name(name);
-            params.set_ssml_gender(gender);
         }
 
         std::string getparams() const
         {
-            auto gender = params.ssml_gender();
-            return params.language_code() + "/" + params.name() + "/" +
+            return getparams(getvoice());
+        }
+
+        std::string getparams(const voice_t& voice) const
+        {
+            const auto& [code, name, gender] = getmappedvoice(voice);
+            return code + "/" + name + "/" +
                    std::string(gender == ssmlgender::MALE     ? "male"
                                : gender == ssmlgender::FEMALE ? "female"
                                                               : "unknown");
@@ -274,12 +396,251 @@ struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
 
       private:
         const Handler* handler;
-        texttospeech_type::TextToSpeechClient client;
-        texttospeech::SynthesisInput input;
-        texttospeech::VoiceSelectionParams params;
-        texttospeech::AudioConfig audio;
+        const texttospeech_type::TextToSpeechClient client;
+        const texttospeech::AudioConfig audio;
+        // default voice only, requests never share mutable state
+        mutable std::mutex mtx;
         voice_t voice;
+
+        static texttospeech::SynthesisInput getinput(const std::string& text)
+        {
+            texttospeech::SynthesisInput input;
+            input.set_text(text);
+            return input;
+        }
+
+        static texttospeech::VoiceSelectionParams
+            getvoiceparams(const voice_t& voice)
+        {
+            texttospeech::VoiceSelectionParams params;
+            const auto& [code, name, gender] = getmappedvoice(voice);
+            params.set_language_code(code);
+            params.set_name(name);
+            params.set_ssml_gender(gender);
+            return params;
+        }
+
+        // language and gender of mapped voice, name of streaming one
+        static texttospeech::VoiceSelectionParams
+            getstreamvoiceparams(const voice_t& voice)
+        {
+            texttospeech::VoiceSelectionParams params;
+            const auto& [code, name, gender] = getmappedvoice(voice);
+            params.set_language_code(code);
+            params.set_name(code + streamVoiceFamily +
+                            streamVoiceMap.at(gender));
+            params.set_ssml_gender(gender);
+            return params;
+        }
+
+        static const decltype(voiceMap)::mapped_type&
+            getmappedvoice(const voice_t& voice)
+        {
+            voice_t defaultvoice = {std::get<language>(voice),
+                                    std::get<gender>(voice), 1};
+            return voiceMap.contains(voice) ? voiceMap.at(voice)
+                                            : voiceMap.at(defaultvoice);
+        }
     } google;
+    Canceller canceller;
+    const std::shared_ptr<playback::Player> player{getplayer(options)};
+    Pipeline pipeline{logif, shell, player, options.synthesizeahead};
+    mutable std::mutex streammtx;
+    streamstats_t streamstats{};
+    std::chrono::milliseconds firstaudiototal{};
+    // declared last, so worker stops before anything it uses is released
+    SpeakQueue queue{options.queuesize, options.policy};
+
+    // segments are synthesized on pool, with owned copies of arguments
+    spoken_t play(const std::string& text, const voice_t& voice,
+                  std::shared_ptr<CancelToken> token)
+    {
+        if (options.streaming && player)
+            return playstream(text, voice, token);
+        return pipeline.play(
+            text,
+            [this, &voice, &token](const std::string& sentence,
+                                   size_t segment) {
+                return pipeline.async([this, sentence, voice, segment,
+                                       token]() {
+                    return segment_t{
+                        getplayback(sentence, voice, segment, token), {}};
+                });
+            },
+            token);
+    }
+
+    // pieces are played on pool while stream is read, so sink never holds
+    // synthesis back, and piece arriving after all earlier audio was played
+    // out is counted as underrun
+    spoken_t playstream(const std::string& text, const voice_t& voice,
+                        std::shared_ptr<CancelToken> token)
+    {
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        const playback::format_t format{streamSampleRate, 1};
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<std::vector<int16_t>> pieces;
+        bool finished{false};
+        std::atomic<bool> failed{false};
+        std::optional<clock::duration> firstaudio;
+        uint64_t underruns{};
+        clock::duration starved{};
+
+        // player is paced by sink, so it holds pool worker for whole
+        // utterance; its group waits for it if call is left early
+        TaskGroup players{ThreadPool::getdefault(), 1};
+        auto playing = players.async([&]() {
+            std::optional<clock::time_point> playedto;
+            while (true)
+            {
+                std::unique_lock lock(mtx);
+                cv.wait(lock, [&]() { return finished || !pieces.empty(); });
+                if (pieces.empty())
+                    return;
+                auto samples = std::move(pieces.front());
+                pieces.pop_front();
+                lock.unlock();
+                const auto now = clock::now();
+                if (!playedto)
+                {
+                    firstaudio = now - start;
+                    playedto = now;
+                }
+                else if (now > *playedto + underrunSlack)
+                {
+                    underruns++;
+                    starved += now - *playedto;
+                    playedto = now;
+                }
+                else
+                    playedto = std::max(*playedto, now);
+                *playedto += std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>((double)samples.size() /
+                                                  format.rate));
+                if (!player->play(samples, format, token))
+                {
+                    failed = true;
+                    return;
+                }
+            }
+        });
+
+        // sample split between two pieces is carried over to next one
+        std::string carry;
+        const auto streamed = google.streamaudio(
+            text, voice,
+            [&](std::string_view audio) {
+                if (failed || token->iscancelled())
+                    return false;
+                carry.append(audio);
+                std::vector<int16_t> samples(carry.size() / sizeof(int16_t));
+                std::memcpy(samples.data(), carry.data(),
+                            samples.size() * sizeof(int16_t));
+                carry.erase(0, samples.size() * sizeof(int16_t));
+                if (!samples.empty())
+                {
+                    std::lock_guard lock(mtx);
+                    pieces.push_back(std::move(samples));
+                    cv.notify_one();
+                }
+                return true;
+            },
+            canceller.gettoken(options.timeout), token);
+        {
+            std::lock_guard lock(mtx);
+            finished = true;
+        }
+        cv.notify_one();
+        playing.get();
+
+        // text is streamed sentence by sentence
+        spoken_t spoken{false, std::nullopt, splitsentences(text).size()};
+        if (firstaudio)
+            spoken.firstaudio =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    *firstaudio);
+        if (token->iscancelled())
+        {
+            log(logs::level::debug, "Speaking cancelled: '" + text + "'");
+            return spoken;
+        }
+        if (spoken.firstaudio)
+        {
+            const auto ttfa = *spoken.firstaudio;
+            const auto gaps =
+                std::chrono::duration_cast<std::chrono::milliseconds>(starved);
+            {
+                std::lock_guard lock{streammtx};
+                streamstats.streams++;
+                streamstats.underruns += underruns;
+                streamstats.starved += gaps;
+                firstaudiototal += ttfa;
+                streamstats.firstaudiomax =
+                    std::max(streamstats.firstaudiomax, ttfa);
+            }
+            log(logs::level::info, "Time to first audio: " +
+                                       str(ttfa.count()) +
+                                       " ms, underruns: " + str(underruns) +
+                                       ", starved: " + str(gaps.count()) +
+                                       " ms");
+        }
+        if (failed)
+            log(logs::level::error, "Cannot play streamed audio");
+        spoken.spoken = streamed && !failed && player->drain(token);
+        return spoken;
+    }
+
+    std::string getplayback(const std::string& text, const voice_t& voice,
+                            size_t segment,
+                            const std::shared_ptr<CancelToken>& token)
+    {
+        const auto key = getkey(text, voice);
+        if (options.diskcache)
+        {
+            if (auto file = options.diskcache->get(key))
+            {
+                log(logs::level::debug,
+                    "Using disk cached audio: '" + file->native() + "'");
+                return file->native();
+            }
+        }
+        auto audio = getaudio(key, [this, &text, &voice]() {
+            return google.getaudio(text, voice,
+                                   canceller.gettoken(options.timeout));
+        });
+        // abandoned utterance must not overwrite segment of following one
+        if (token->iscancelled())
+            return {};
+        if (options.diskcache)
+        {
+            if (auto file = options.diskcache->put(key, *audio))
+                return file->native();
+        }
+        filesystem.savetofile(*audio, segment);
+        return filesystem.getpath(segment).native();
+    }
+
+    audiokey_t getkey(const std::string& text, const voice_t& voice) const
+    {
+        return {text, google.getparams(voice),
+                texttospeech::AudioEncoding_Name(audioEncoding)};
+    }
+
+    audio_t getaudio(const audiokey_t& key,
+                     const std::function<std::string()>& synthesize)
+    {
+        if (!options.cache)
+            return std::make_shared<const std::string>(synthesize());
+        if (auto audio = options.cache->get(key))
+        {
+            log(logs::level::debug, "Using cached audio of size: " +
+                                        str(audio->size()));
+            return audio;
+        }
+        return options.cache->put(key, synthesize());
+    }
 
     void log(
         logs::level level, const std::string& msg,
@@ -317,6 +678,17 @@ bool TextToVoice::speak(const std::string& text, const voice_t& voice)
     return handler->speak(text, voice);
 }
 
+speakhandle_t TextToVoice::enqueue(const std::string& text)
+{
+    return handler->enqueue(text);
+}
+
+speakhandle_t TextToVoice::enqueue(const std::string& text,
+                                   const voice_t& voice)
+{
+    return handler->enqueue(text, voice);
+}
+
 bool TextToVoice::speakasync(const std::string& text)
 {
     return handler->speakasync(text);
@@ -332,6 +704,16 @@ bool TextToVoice::waitspoken()
     return handler->waitspoken();
 }
 
+audio_t TextToVoice::synthesize(const std::string& text)
+{
+    return handler->synthesize(text);
+}
+
+audio_t TextToVoice::synthesize(const std::string& text, const voice_t& voice)
+{
+    return handler->synthesize(text, voice);
+}
+
 voice_t TextToVoice::getvoice()
 {
     return handler->getvoice();
@@ -342,4 +724,14 @@ void TextToVoice::setvoice(const voice_t& voice)
     handler->setvoice(voice);
 }
 
+bool TextToVoice::cancel()
+{
+    return handler->cancel();
+}
+
+streamstats_t TextToVoice::getstreamstats() const
+{
+    return handler->getstreamstats();
+}
+
 } // namespace tts::googlecloud
@@ -0,0 +1,522 @@
+#include "speech/tts/interfaces/hedged.hpp"
+
+#include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/cancel.hpp"
+#include "speech/helpers.hpp"
+#include "speech/threadpool.hpp"
+#include "speech/tts/pipeline.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <source_location>
+
+namespace tts::hedged
+{
+
+using namespace speech::helpers;
+using namespace std::string_literals;
+
+// attempts of concurrent syntheses queued or running on pool at once
+static constexpr size_t attemptsInFlight = 16;
+// latencies kept per backend for percentiles
+static constexpr size_t latencyWindow = 1000;
+
+struct TextToVoice::Handler : public std::enable_shared_from_this<Handler>
+{
+  public:
+    explicit Handler(const configmin_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        backends{std::get<backends_t>(config)},
+        hedge{std::get<hedgeconfig_t>(config)}, stats{this}
+    {
+        init();
+    }
+
+    explicit Handler(const configext_t& config) :
+        logif{std::get<std::shared_ptr<logs::LogIf>>(config)},
+        shell{shell::Factory::create<shell::lnx::bash::Shell>()},
+        options{std::get<options_t>(config)},
+        backends{std::get<backends_t>(config)},
+        hedge{std::get<hedgeconfig_t>(config)}, stats{this}
+    {
+        init();
+    }
+
+    ~Handler()
+    {
+        log(logs::level::info, "Released hedged tts, backends: " +
+                                   str(backends.size()));
+    }
+
+    bool speak(const std::string& text)
+    {
+        return enqueue(text).get().spoken;
+    }
+
+    bool speak(const std::string& text, const voice_t& voice)
+    {
+        return enqueue(text, voice).get().spoken;
+    }
+
+    speakhandle_t enqueue(const std::string& text)
+    {
+        return enqueue(text, getvoice());
+    }
+
+    speakhandle_t enqueue(const std::string& text, const voice_t& voice)
+    {
+        log(logs::level::debug, "Queued text to speak: '" + text + "'");
+        // token is taken now, so cancel reaches utterance still in queue
+        return queue.push([this, text, voice, token = canceller.gettoken()]() {
+            return play(text, voice, token);
+        });
+    }
+
+    bool speakasync(const std::string& text)
+    {
+        return Pipeline::isaccepted(enqueue(text));
+    }
+
+    bool speakasync(const std::string& text, const voice_t& voice)
+    {
+        return Pipeline::isaccepted(enqueue(text, voice));
+    }
+
+    bool waitspoken()
+    {
+        return queue.wait();
+    }
+
+    audio_t synthesize(const std::string& text)
+    {
+        return synthesize(text, getvoice());
+    }
+
+    // attempts get tokens linked to one of synthesis, so cancel and
+    // deadline reach all of them, and transfers of backends with them
+    audio_t synthesize(const std::string& text, const voice_t& voice)
+    {
+        const auto token = canceller.gettoken(options.timeout);
+        auto race = std::make_shared<Race>();
+        CancelCallback stop{token, [race]() {
+                                std::lock_guard lock(race->mtx);
+                                race->cancelled = true;
+                                race->cv.notify_all();
+                            }};
+        CancelScope scope{token};
+        const auto settled = [&race]() {
+            return race->audio || race->cancelled ||
+                   race->failed == race->attempts.size();
+        };
+
+        size_t launched{};
+        while (true)
+        {
+            launch(race, text, voice, launched++);
+            std::unique_lock lock(race->mtx);
+            if (launched == hedge.attempts)
+            {
+                race->cv.wait(lock, settled);
+                break;
+            }
+            // next attempt at once when all so far failed
+            if (race->cv.wait_for(lock, hedge.delay, settled) &&
+                (race->audio || race->cancelled))
+                break;
+        }
+
+        std::unique_lock lock(race->mtx);
+        const auto audio = race->audio;
+        const auto winner = race->winner;
+        const auto error = race->error;
+        std::vector<std::pair<size_t, std::shared_ptr<CancelToken>>> losers;
+        for (const auto& attempt : race->attempts)
+            if (!attempt.done)
+                losers.emplace_back(attempt.backend, attempt.token);
+        lock.unlock();
+
+        // losers are cancelled outside of race lock, as their tokens call
+        // back into it
+        std::vector<size_t> cancelled;
+        for (const auto& [backend, loser] : losers)
+            if (loser->cancel())
+                cancelled.push_back(backend);
+        stats.finish(launched, winner ? std::optional{race->backendof(*winner)}
+                                      : std::nullopt,
+                     winner.value_or(0) > 0, cancelled);
+
+        if (audio)
+        {
+            if (*winner > 0)
+                log(logs::level::debug,
+                    "Hedged attempt " + str(*winner) + " won with backend " +
+                        str(race->backendof(*winner)));
+            return audio;
+        }
+        if (token->iscancelled() || !error)
+            throw std::runtime_error("Synthesis cancelled: '" + text + "'");
+        std::rethrow_exception(error);
+    }
+
+    bool cancel()
+    {
+        // utterances in queue are dropped first, so none starts meanwhile;
+        // attempts still queued on pool see their tokens tripped and end at
+        // once, backends themselves are not cancelled as others may use them
+        auto pending = queue.cancel();
+        pending = canceller.cancel() || pending;
+        pipeline.cancel();
+        log(logs::level::debug, "Speech cancelled, was pending: " +
+                                    std::string(pending ? "yes" : "no"));
+        return pending;
+    }
+
+    void setvoice(const voice_t& voice)
+    {
+        std::lock_guard lock{mtx};
+        this->voice = voice;
+    }
+
+    voice_t getvoice() const
+    {
+        std::lock_guard lock{mtx};
+        return voice;
+    }
+
+    hedgestats_t getstats() const
+    {
+        return stats.get();
+    }
+
+  private:
+    const std::shared_ptr<logs::LogIf> logif;
+    const std::shared_ptr<shell::ShellIf> shell;
+    const options_t options;
+    const backends_t backends;
+    const hedgeconfig_t hedge;
+    // default voice only, requests never share mutable state
+    mutable std::mutex mtx;
+    voice_t voice;
+
+    // outcome of one synthesis, first attempt with audio wins it
+    struct Race
+    {
+        struct Attempt
+        {
+            size_t backend;
+            std::shared_ptr<CancelToken> token;
+            bool done;
+        };
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::vector<Attempt> attempts;
+        audio_t audio;
+        std::optional<size_t> winner;
+        size_t failed{};
+        std::exception_ptr error;
+        bool cancelled{false};
+
+        size_t backendof(size_t attempt)
+        {
+            std::lock_guard lock(mtx);
+            return attempts.at(attempt).backend;
+        }
+    };
+
+    class Stats
+    {
+      public:
+        explicit Stats(const Handler* handler) :
+            backends(handler->backends.size())
+        {}
+
+        void request(size_t backend, bool hedge)
+        {
+            std::lock_guard lock(mtx);
+            backends.at(backend).stats.requests++;
+            if (hedge)
+                backends.at(backend).stats.hedges++;
+        }
+
+        void attempt(size_t backend, std::chrono::milliseconds latency,
+                     bool succeeded, bool cancelled)
+        {
+            std::lock_guard lock(mtx);
+            auto& entry = backends.at(backend);
+            if (succeeded)
+            {
+                entry.latencies.push_back(latency);
+                if (entry.latencies.size() > latencyWindow)
+                    entry.latencies.pop_front();
+            }
+            else if (!cancelled)
+                entry.stats.failures++;
+        }
+
+        void finish(size_t attempts, std::optional<size_t> winner,
+                    bool hedgewin, const std::vector<size_t>& cancelled)
+        {
+            std::lock_guard lock(mtx);
+            syntheses++;
+            hedged += attempts > 1 ? 1 : 0;
+            hedgewins += hedgewin ? 1 : 0;
+            if (winner)
+                backends.at(*winner).stats.wins++;
+            for (auto backend : cancelled)
+                backends.at(backend).stats.cancelled++;
+        }
+
+        hedgestats_t get() const
+        {
+            std::lock_guard lock(mtx);
+            hedgestats_t result{syntheses, hedged, hedgewins, 0., 0., {}};
+            if (syntheses > 0)
+                result.hedgerate = (double)hedged / (double)syntheses;
+            if (hedged > 0)
+                result.hedgewinrate = (double)hedgewins / (double)hedged;
+            for (const auto& entry : backends)
+            {
+                auto stats = entry.stats;
+                stats.p50 = percentile(entry.latencies, 50);
+                stats.p99 = percentile(entry.latencies, 99);
+                result.backends.push_back(stats);
+            }
+            return result;
+        }
+
+      private:
+        struct Entry
+        {
+            backendstats_t stats{};
+            std::deque<std::chrono::milliseconds> latencies;
+        };
+
+        mutable std::mutex mtx;
+        uint64_t syntheses{};
+        uint64_t hedged{};
+        uint64_t hedgewins{};
+        std::vector<Entry> backends;
+
+        static std::chrono::milliseconds
+            percentile(const std::deque<std::chrono::milliseconds>& window,
+                       size_t rank)
+        {
+            if (window.empty())
+                return {};
+            std::vector<std::chrono::milliseconds> sorted{window.begin(),
+                                                          window.end()};
+            auto nth = sorted.begin() + (sorted.size() - 1) * rank / 100;
+            std::nth_element(sorted.begin(), nth, sorted.end());
+            return *nth;
+        }
+    } stats;
+    Canceller canceller;
+    // attempts hold owned copies of their arguments, as pool futures do
+    // not wait for task when dropped
+    TaskGroup tasks{ThreadPool::getdefault(), attemptsInFlight};
+    // segments end before attempts they wait for are dropped
+    const std::shared_ptr<playback::Player> player{getplayer(options)};
+    Pipeline pipeline{logif, shell, player, options.synthesizeahead};
+    // declared last, so worker stops before anything it uses is released
+    SpeakQueue queue{options.queuesize, options.policy};
+
+    void init()
+    {
+        if (backends.empty() || hedge.attempts == 0 ||
+            std::ranges::any_of(backends,
+                                [](const auto& backend) { return !backend; }))
+            throw std::runtime_error(
+                std::source_location::current().function_name() +
+                "-> backends or attempts not given"s);
+        voice = backends.front()->getvoice();
+        log(logs::level::info,
+            "Created hedged tts, backends: " + str(backends.size()) +
+                ", attempts: " + str(hedge.attempts) +
+                ", delay: " + str(hedge.delay.count()) + " ms");
+    }
+
+    // token is taken within scope of synthesis, so it is linked to its one
+    void launch(const std::shared_ptr<Race>& race, const std::string& text,
+                const voice_t& voice, size_t attempt)
+    {
+        const auto backend = attempt % backends.size();
+        auto token = canceller.gettoken();
+        {
+            std::lock_guard lock(race->mtx);
+            race->attempts.push_back({backend, token, false});
+        }
+        stats.request(backend, attempt > 0);
+        if (attempt > 0)
+            log(logs::level::debug,
+                "Hedging synthesis with backend " + str(backend) + ": '" +
+                    text + "'");
+        // group full runs attempt here, so it is not hedged but still done
+        tasks.async([this, race, text, voice, attempt, backend, token]() {
+            run(race, text, voice, attempt, backend, token);
+        });
+    }
+
+    void run(const std::shared_ptr<Race>& race, const std::string& text,
+             const voice_t& voice, size_t attempt, size_t backend,
+             const std::shared_ptr<CancelToken>& token)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        audio_t audio;
+        std::exception_ptr error;
+        try
+        {
+            if (token->iscancelled())
+                throw std::runtime_error("Attempt cancelled");
+            // transfers of backend are aborted with this attempt
+            CancelScope scope{token};
+            if (!(audio = backends.at(backend)->synthesize(text, voice)))
+                throw std::runtime_error("No audio synthesized");
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        stats.attempt(backend,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start),
+                      audio != nullptr, token->iscancelled());
+
+        std::lock_guard lock(race->mtx);
+        race->attempts.at(attempt).done = true;
+        if (!audio)
+        {
+            race->failed++;
+            race->error = error;
+        }
+        else if (!race->audio && !race->cancelled)
+        {
+            race->audio = audio;
+            race->winner = attempt;
+        }
+        race->cv.notify_all();
+    }
+
+    // segment is synthesized under token of utterance, so cancel and
+    // deadline reach its attempts
+    spoken_t play(const std::string& text, const voice_t& voice,
+                  std::shared_ptr<CancelToken> token)
+    {
+        try
+        {
+            return pipeline.play(
+                text,
+                [this, &voice, &token](const std::string& sentence, size_t) {
+                    return pipeline.async([this, sentence, voice, token]() {
+                        CancelScope scope{token};
+                        return segment_t{{}, synthesize(sentence, voice)};
+                    });
+                },
+                token);
+        }
+        catch (const std::exception& ex)
+        {
+            if (!token->iscancelled())
+                log(logs::level::error,
+                    "Cannot synthesize text: "s + ex.what());
+            return {};
+        }
+    }
+
+    void log(
+        logs::level level, const std::string& msg,
+        const std::source_location loc = std::source_location::current()) const
+    {
+        if (logif)
+            logif->log(level, std::string{loc.function_name()}, msg);
+    }
+};
+
+TextToVoice::TextToVoice(const config_t& config)
+{
+    handler = std::visit(
+        [](const auto& config) -> decltype(TextToVoice::handler) {
+            if constexpr (!std::is_same<const std::monostate&,
+                                        decltype(config)>())
+            {
+                return std::make_shared<TextToVoice::Handler>(config);
+            }
+            throw std::runtime_error(
+                std::source_location::current().function_name() +
+                "-> config not supported"s);
+        },
+        config);
+}
+TextToVoice::~TextToVoice() = default;
+
+bool TextToVoice::speak(const std::string& text)
+{
+    return handler->speak(text);
+}
+
+bool TextToVoice::speak(const std::string& text, const voice_t& voice)
+{
+    return handler->speak(text, voice);
+}
+
+speakhandle_t TextToVoice::enqueue(const std::string& text)
+{
+    return handler->enqueue(text);
+}
+
+speakhandle_t TextToVoice::enqueue(const std::string& text,
+                                   const voice_t& voice)
+{
+    return handler->enqueue(text, voice);
+}
+
+bool TextToVoice::speakasync(const std::string& text)
+{
+    return handler->speakasync(text);
+}
+
+bool TextToVoice::speakasync(const std::string& text, const voice_t& voice)
+{
+    return handler->speakasync(text, voice);
+}
+
+bool TextToVoice::waitspoken()
+{
+    return handler->waitspoken();
+}
+
+audio_t TextToVoice::synthesize(const std::string& text)
+{
+    return handler->synthesize(text);
+}
+
+audio_t TextToVoice::synthesize(const std::string& text, const voice_t& voice)
+{
+    return handler->synthesize(text, voice);
+}
+
+voice_t TextToVoice::getvoice()
+{
+    return handler->getvoice();
+}
+
+void TextToVoice::setvoice(const voice_t& voice)
+{
+    handler->setvoice(voice);
+}
+
+bool TextToVoice::cancel()
+{
+    return handler->cancel();
+}
+
+hedgestats_t TextToVoice::getstats() const
+{
+    return handler->getstats();
+}
+
+} // namespace tts::hedged
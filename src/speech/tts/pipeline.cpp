@@ -0,0 +1,146 @@
+#include "speech/tts/pipeline.hpp"
+
+#include "speech/command.hpp"
+#include "speech/helpers.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+
+namespace tts
+{
+
+using namespace speech::helpers;
+
+Pipeline::Pipeline(std::shared_ptr<logs::LogIf> logif,
+                   std::shared_ptr<shell::ShellIf> shell,
+                   std::shared_ptr<playback::Player> player, size_t ahead) :
+    logif{logif}, shell{shell}, player{player}, ahead{ahead},
+    tasks{ThreadPool::getdefault(), ahead + 1}
+{}
+
+spoken_t Pipeline::play(const std::string& text,
+                        const synthesizer_t& synthesize,
+                        const std::shared_ptr<CancelToken>& token)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto sentences =
+        ahead > 0 ? splitsentences(text) : std::vector<std::string>{text};
+    spoken_t spoken{false, std::nullopt, sentences.size()};
+    std::deque<synthesis_t> segments;
+    for (size_t next{}, played{}; played < sentences.size(); played++)
+    {
+        for (; next < sentences.size() && segments.size() <= ahead; next++)
+            segments.push_back(synthesize(sentences[next], next));
+        // synthesis left behind finishes on its own, result is dropped
+        if (!token->wait(segments.front()))
+        {
+            log(logs::level::debug, "Speaking cancelled: '" + text + "'");
+            return spoken;
+        }
+        auto segment = segments.front().get();
+        segments.pop_front();
+        if (played == 0)
+        {
+            spoken.firstaudio =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start);
+            log(logs::level::info,
+                "Time to first audio: " + str(spoken.firstaudio->count()) +
+                    " ms, segments: " + str(sentences.size()));
+        }
+        if (!playsegment(segment, token))
+            return spoken;
+    }
+    spoken.spoken = player ? player->drain(token) : true;
+    return spoken;
+}
+
+Pipeline::synthesis_t Pipeline::async(std::function<segment_t()>&& synthesize)
+{
+    return tasks.async(std::move(synthesize));
+}
+
+bool Pipeline::cancel()
+{
+    return tasks.cancel();
+}
+
+bool Pipeline::isaccepted(const speakhandle_t& handle)
+{
+    using namespace std::chrono_literals;
+    return handle.wait_for(0s) != std::future_status::ready ||
+           handle.get().spoken;
+}
+
+bool Pipeline::playsegment(const segment_t& segment,
+                           const std::shared_ptr<CancelToken>& token)
+{
+    // abandoned synthesis gives nothing to play
+    if (token->iscancelled())
+        return false;
+    return segment.audio ? playaudio(*segment.audio, token)
+                         : playfile(segment.file, token);
+}
+
+bool Pipeline::playfile(const std::string& file,
+                        const std::shared_ptr<CancelToken>& token)
+{
+    if (!player)
+    {
+        // external player fallback, only player spawned here is killed,
+        // others are left alone
+        Command command{shell};
+        CancelCallback kill{token, [&command]() { command.kill(); }};
+        command.run(getplaybackcmd(file));
+        return !token->iscancelled();
+    }
+    if (!player->play(std::filesystem::path{file}, token))
+    {
+        if (!token->iscancelled())
+            log(logs::level::error, "Cannot play audio file: '" + file + "'");
+        return false;
+    }
+    return true;
+}
+
+// audio is either mp3 or wav, external player tells them apart by
+// extension of temporary file it is given
+bool Pipeline::playaudio(const std::string& audio,
+                         const std::shared_ptr<CancelToken>& token)
+{
+    if (player)
+    {
+        if (!player->play(std::string_view{audio}, token))
+        {
+            if (!token->iscancelled())
+                log(logs::level::error,
+                    "Cannot play audio of size: " + str(audio.size()));
+            return false;
+        }
+        return true;
+    }
+    static std::atomic<uint64_t> files{};
+    const auto file =
+        std::filesystem::temp_directory_path() /
+        ("speech-audio-" + str(getpid()) + "-" + str(files++) +
+         (audio.starts_with("RIFF") ? ".wav" : ".mp3"));
+    std::ofstream(file, std::ios::binary) << audio;
+    const auto played = playfile(file.native(), token);
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+    return played;
+}
+
+void Pipeline::log(logs::level level, const std::string& msg,
+                   const std::source_location loc) const
+{
+    if (logif)
+        logif->log(level, std::string{loc.function_name()}, msg);
+}
+
+} // namespace tts
@@ -0,0 +1,153 @@
+#include "speech/tts/playback.hpp"
+
+#include "speech/mappedfile.hpp"
+
+#define MINIMP3_IMPLEMENTATION
+#include <minimp3.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace tts::playback
+{
+
+// longest audio written at once when play can be cancelled
+static constexpr uint32_t writePieceMs{10};
+
+template <typename T>
+static T getle(std::string_view data, size_t offset)
+{
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+static bool iswav(std::string_view audio)
+{
+    return audio.size() >= 12 && audio.substr(0, 4) == "RIFF" &&
+           audio.substr(8, 4) == "WAVE";
+}
+
+Player::Player(std::shared_ptr<SinkIf> sink) : sink{sink}
+{}
+
+// sink is stopped only while this call owns it, so cancelling one owner
+// never cuts audio of another one sharing player
+bool Player::play(std::string_view audio,
+                  std::shared_ptr<speech::helpers::CancelToken> token)
+{
+    std::lock_guard lock(mtx);
+    speech::helpers::CancelCallback stop{token, [this]() { sink->stop(); }};
+    return iswav(audio) ? playwav(audio, token.get())
+                        : playmp3(audio, token.get());
+}
+
+// file is mapped, so cached audio is decoded without being read into memory
+bool Player::play(const std::filesystem::path& file,
+                  std::shared_ptr<speech::helpers::CancelToken> token)
+{
+    const speech::helpers::MappedFile audio{file.native()};
+    return audio && play(audio.view(), token);
+}
+
+bool Player::play(std::span<const int16_t> samples, const format_t& format,
+                  std::shared_ptr<speech::helpers::CancelToken> token)
+{
+    std::lock_guard lock(mtx);
+    speech::helpers::CancelCallback stop{token, [this]() { sink->stop(); }};
+    return sink->open(format) && write(samples, format, token.get());
+}
+
+bool Player::drain(std::shared_ptr<speech::helpers::CancelToken> token)
+{
+    std::lock_guard lock(mtx);
+    speech::helpers::CancelCallback stop{token, [this]() { sink->stop(); }};
+    return sink->drain() && !(token && token->iscancelled());
+}
+
+bool Player::playwav(std::string_view audio,
+                     const speech::helpers::CancelToken* token)
+{
+    std::optional<format_t> format;
+    for (size_t offset{12}; offset + 8 <= audio.size();)
+    {
+        auto id = audio.substr(offset, 4);
+        auto size = std::min<size_t>(getle<uint32_t>(audio, offset + 4),
+                                     audio.size() - offset - 8);
+        auto chunk = audio.substr(offset + 8, size);
+        if (id == "fmt " && chunk.size() >= 16)
+        {
+            if (getle<uint16_t>(chunk, 0) != 1 ||
+                getle<uint16_t>(chunk, 14) != 16)
+                return false;
+            format = {getle<uint32_t>(chunk, 4), getle<uint16_t>(chunk, 2)};
+        }
+        else if (id == "data" && format)
+        {
+            // samples are written in place, unless unaligned in memory
+            const auto count = chunk.size() / sizeof(int16_t);
+            if ((uintptr_t)chunk.data() % alignof(int16_t) == 0)
+                return sink->open(*format) &&
+                       write({(const int16_t*)chunk.data(), count}, *format,
+                             token);
+            std::vector<int16_t> samples(count);
+            std::memcpy(samples.data(), chunk.data(),
+                        samples.size() * sizeof(int16_t));
+            return sink->open(*format) && write(samples, *format, token);
+        }
+        // chunks are word aligned
+        offset += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// frames are decoded and written one by one, so playback starts right away
+bool Player::playmp3(std::string_view audio,
+                     const speech::helpers::CancelToken* token)
+{
+    mp3dec_t decoder;
+    mp3dec_init(&decoder);
+    mp3dec_frame_info_t info{};
+    std::vector<mp3d_sample_t> pcm(MINIMP3_MAX_SAMPLES_PER_FRAME);
+    bool played{false};
+    for (size_t offset{}; offset < audio.size(); offset += info.frame_bytes)
+    {
+        auto samples = mp3dec_decode_frame(
+            &decoder, (const uint8_t*)audio.data() + offset,
+            (int)std::min<size_t>(audio.size() - offset, INT_MAX), pcm.data(),
+            &info);
+        if (info.frame_bytes == 0)
+            break;
+        if (samples == 0)
+            continue;
+        const format_t format{(uint32_t)info.hz, (uint16_t)info.channels};
+        if (!sink->open(format) ||
+            !write({pcm.data(), (size_t)(samples * info.channels)}, format,
+                   token))
+            return false;
+        played = true;
+    }
+    return played;
+}
+
+bool Player::write(std::span<const int16_t> samples, const format_t& format,
+                   const speech::helpers::CancelToken* token)
+{
+    if (token == nullptr)
+        return sink->write(samples);
+    // whole frames only, channels of one frame never go apart
+    const size_t piece =
+        std::max<size_t>(1, (size_t)format.rate * writePieceMs / 1000) *
+        format.channels;
+    for (size_t offset{}; offset < samples.size(); offset += piece)
+        if (token->iscancelled() ||
+            !sink->write(samples.subspan(
+                offset, std::min(piece, samples.size() - offset))))
+            return false;
+    return !token->iscancelled();
+}
+
+} // namespace tts::playback
@@ -0,0 +1,261 @@
+#include "speech/tts/sinks.hpp"
+
+#include <alsa/asoundlib.h>
+
+#include <fstream>
+#include <mutex>
+
+namespace tts::playback
+{
+
+static constexpr uint32_t alsaLatencyUs{100000};
+
+struct AlsaSink::Handler
+{
+  public:
+    explicit Handler(const std::string& device) : device{device}
+    {}
+
+    ~Handler()
+    {
+        close();
+    }
+
+    bool open(const format_t& format)
+    {
+        std::lock_guard lock(mtx);
+        if (pcm != nullptr && format == current)
+            return !stopped.exchange(false) || snd_pcm_prepare(pcm) >= 0;
+        stopped = false;
+        close();
+        if (snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0) <
+            0)
+        {
+            pcm = nullptr;
+            return false;
+        }
+        if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE,
+                               SND_PCM_ACCESS_RW_INTERLEAVED, format.channels,
+                               format.rate, 1, alsaLatencyUs) < 0)
+        {
+            close();
+            return false;
+        }
+        current = format;
+        return true;
+    }
+
+    bool write(std::span<const int16_t> samples)
+    {
+        if (pcm == nullptr)
+            return false;
+        auto data = samples.data();
+        auto frames = (snd_pcm_uframes_t)(samples.size() / current.channels);
+        while (frames > 0)
+        {
+            if (stopped)
+                return false;
+            auto written = snd_pcm_writei(pcm, data, frames);
+            if (written < 0)
+            {
+                // underrun or suspend, device is prepared again
+                if (stopped || snd_pcm_recover(pcm, (int)written, 1) < 0)
+                    return false;
+                continue;
+            }
+            data += written * current.channels;
+            frames -= (snd_pcm_uframes_t)written;
+        }
+        return true;
+    }
+
+    // device stays open and is prepared for next utterance after drain
+    bool drain()
+    {
+        if (pcm == nullptr)
+            return true;
+        if (stopped.exchange(false))
+            return snd_pcm_prepare(pcm) >= 0;
+        auto drained = snd_pcm_drain(pcm) >= 0;
+        return snd_pcm_prepare(pcm) >= 0 && drained && !stopped;
+    }
+
+    // buffered audio is dropped, which also wakes writer blocked on full
+    // buffer; device is prepared again by writer on next open or drain
+    bool stop()
+    {
+        std::lock_guard lock(mtx);
+        stopped = true;
+        return pcm == nullptr || snd_pcm_drop(pcm) >= 0;
+    }
+
+  private:
+    const std::string device;
+    // guards device handle against stop from other thread, playing thread
+    // alone writes, so it does not need lock for that
+    std::mutex mtx;
+    snd_pcm_t* pcm{nullptr};
+    format_t current{};
+    std::atomic<bool> stopped{false};
+
+    void close()
+    {
+        if (pcm != nullptr)
+        {
+            snd_pcm_drain(pcm);
+            snd_pcm_close(pcm);
+            pcm = nullptr;
+        }
+    }
+};
+
+AlsaSink::AlsaSink(const std::string& device) :
+    handler{std::make_shared<Handler>(device)}
+{}
+AlsaSink::~AlsaSink() = default;
+
+bool AlsaSink::open(const format_t& format)
+{
+    return handler->open(format);
+}
+
+bool AlsaSink::write(std::span<const int16_t> samples)
+{
+    return handler->write(samples);
+}
+
+bool AlsaSink::drain()
+{
+    return handler->drain();
+}
+
+bool AlsaSink::stop()
+{
+    return handler->stop();
+}
+
+bool NullSink::open(const format_t&)
+{
+    return true;
+}
+
+bool NullSink::write(std::span<const int16_t> data)
+{
+    samples += data.size();
+    return true;
+}
+
+bool NullSink::drain()
+{
+    return true;
+}
+
+bool NullSink::stop()
+{
+    return true;
+}
+
+uint64_t NullSink::getsamples() const
+{
+    return samples;
+}
+
+struct WavSink::Handler
+{
+  public:
+    explicit Handler(const std::filesystem::path& path) : path{path}
+    {}
+
+    ~Handler()
+    {
+        drain();
+    }
+
+    // format is set by first audio, one file cannot hold audio of another
+    bool open(const format_t& format)
+    {
+        if (ofs.is_open())
+            return format == current;
+        ofs = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        current = format;
+        databytes = 0;
+        writeheader();
+        return (bool)ofs;
+    }
+
+    bool write(std::span<const int16_t> samples)
+    {
+        ofs.write((const char*)samples.data(),
+                  (std::streamsize)samples.size_bytes());
+        databytes += (uint32_t)samples.size_bytes();
+        return (bool)ofs;
+    }
+
+    // header sizes are updated, so file is valid after every utterance
+    bool drain()
+    {
+        if (!ofs.is_open())
+            return true;
+        ofs.seekp(0);
+        writeheader();
+        ofs.seekp(0, std::ios::end);
+        return (bool)ofs.flush();
+    }
+
+  private:
+    const std::filesystem::path path;
+    std::ofstream ofs;
+    format_t current{};
+    uint32_t databytes{};
+
+    template <typename T>
+    void putle(T value)
+    {
+        ofs.write((const char*)&value, sizeof(value));
+    }
+
+    void writeheader()
+    {
+        const uint16_t blockalign = current.channels * sizeof(int16_t);
+        ofs.write("RIFF", 4);
+        putle<uint32_t>(36 + databytes);
+        ofs.write("WAVEfmt ", 8);
+        putle<uint32_t>(16);
+        putle<uint16_t>(1);
+        putle<uint16_t>(current.channels);
+        putle<uint32_t>(current.rate);
+        putle<uint32_t>(current.rate * blockalign);
+        putle<uint16_t>(blockalign);
+        putle<uint16_t>(16);
+        ofs.write("data", 4);
+        putle<uint32_t>(databytes);
+    }
+};
+
+WavSink::WavSink(const std::filesystem::path& path) :
+    handler{std::make_shared<Handler>(path)}
+{}
+WavSink::~WavSink() = default;
+
+bool WavSink::open(const format_t& format)
+{
+    return handler->open(format);
+}
+
+bool WavSink::write(std::span<const int16_t> samples)
+{
+    return handler->write(samples);
+}
+
+bool WavSink::drain()
+{
+    return handler->drain();
+}
+
+// file is written synchronously, nothing is buffered to be dropped
+bool WavSink::stop()
+{
+    return true;
+}
+
+} // namespace tts::playback
@@ -0,0 +1,132 @@
+#include "speech/tts/speakqueue.hpp"
+
+#include <algorithm>
+
+namespace tts
+{
+
+SpeakQueue::SpeakQueue(size_t capacity, queuepolicy policy) :
+    capacity{std::max<size_t>(capacity, 1)}, policy{policy}
+{
+    worker = std::thread(&SpeakQueue::run, this);
+}
+
+SpeakQueue::~SpeakQueue()
+{
+    {
+        std::lock_guard lock(mtx);
+        running = false;
+    }
+    cv.notify_all();
+    worker.join();
+    for (auto& utterance : utterances)
+        utterance.done.set_value({});
+}
+
+speakhandle_t SpeakQueue::push(job_t&& job)
+{
+    Utterance utterance{std::move(job), {}};
+    auto handle = utterance.done.get_future().share();
+    std::unique_lock lock(mtx);
+    if (utterances.size() >= capacity)
+    {
+        switch (policy)
+        {
+            case queuepolicy::block:
+                cv.wait(lock, [this]() {
+                    return !running || utterances.size() < capacity;
+                });
+                break;
+            case queuepolicy::dropoldest:
+                utterances.front().done.set_value({});
+                utterances.pop_front();
+                stats.dropped++;
+                break;
+            case queuepolicy::reject:
+                stats.rejected++;
+                utterance.done.set_value({});
+                return handle;
+        }
+    }
+    if (!running)
+    {
+        utterance.done.set_value({});
+        return handle;
+    }
+    utterances.push_back(std::move(utterance));
+    stats.queued++;
+    lock.unlock();
+    cv.notify_all();
+    return handle;
+}
+
+bool SpeakQueue::wait()
+{
+    std::unique_lock lock(mtx);
+    if (utterances.empty() && !speaking)
+        return false;
+    cv.wait(lock, [this]() {
+        return !running || (utterances.empty() && !speaking);
+    });
+    return true;
+}
+
+bool SpeakQueue::cancel()
+{
+    std::deque<Utterance> dropped;
+    bool pending{};
+    {
+        std::lock_guard lock(mtx);
+        pending = speaking || !utterances.empty();
+        dropped.swap(utterances);
+        stats.cancelled += dropped.size();
+    }
+    cv.notify_all();
+    for (auto& utterance : dropped)
+        utterance.done.set_value({});
+    return pending;
+}
+
+size_t SpeakQueue::pending() const
+{
+    std::lock_guard lock(mtx);
+    return utterances.size() + (speaking ? 1 : 0);
+}
+
+queuestats_t SpeakQueue::getstats() const
+{
+    std::lock_guard lock(mtx);
+    return stats;
+}
+
+void SpeakQueue::run()
+{
+    std::unique_lock lock(mtx);
+    while (true)
+    {
+        cv.wait(lock, [this]() { return !running || !utterances.empty(); });
+        if (!running)
+            break;
+        auto utterance = std::move(utterances.front());
+        utterances.pop_front();
+        speaking = true;
+        lock.unlock();
+        cv.notify_all();
+
+        try
+        {
+            utterance.done.set_value(utterance.job());
+        }
+        catch (...)
+        {
+            utterance.done.set_exception(std::current_exception());
+        }
+
+        lock.lock();
+        speaking = false;
+        stats.spoken++;
+        cv.notify_all();
+    }
+}
+
+} // namespace tts
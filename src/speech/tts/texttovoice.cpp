@@ -1,6 +1,7 @@
 #include "speech/tts/interfaces/texttovoice.hpp"
 
 #include "shell/interfaces/linux/bash/shell.hpp"
+#include "speech/tts/sinks.hpp"
 
 namespace tts
 {
@@ -11,4 +12,14 @@ void tts::TextToVoiceIf::kill()
         "killall -s KILL play");
 }
 
+std::shared_ptr<playback::Player> getplayer(const options_t& options)
+{
+    if (options.externalplayer)
+        return nullptr;
+    if (options.player)
+        return options.player;
+    return std::make_shared<playback::Player>(
+        std::make_shared<playback::AlsaSink>());
+}
+
 } // namespace tts
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "speech/stt/interfaces/textfromvoice.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// recognizes audio as its size and counts calls in flight
+class FakeTextFromVoice : public stt::TextFromVoiceIf
+{
+  public:
+    stt::transcript_t listen() override
+    {
+        return {};
+    }
+
+    stt::transcript_t listen(stt::language) override
+    {
+        return {};
+    }
+
+    stt::transcript_t listen(const std::vector<stt::language>&) override
+    {
+        return {};
+    }
+
+    std::optional<stt::transcript_t>
+        transcribe(std::span<const std::byte> audio, stt::format,
+                   stt::language) override
+    {
+        auto running = ++inflight;
+        auto seen = peak.load();
+        while (running > seen && !peak.compare_exchange_weak(seen, running))
+            ;
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        inflight--;
+        return stt::transcript_t{std::to_string(audio.size()), 100};
+    }
+
+    void cancel() override
+    {}
+
+    std::atomic<size_t> inflight{}, peak{};
+};
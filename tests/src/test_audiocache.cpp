@@ -0,0 +1,109 @@
+#include "speech/tts/audiocache.hpp"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tts;
+
+class TestAudioCache : public testing::Test
+{
+  public:
+    static audiokey_t getkey(const std::string& text)
+    {
+        return {text, "pl-PL-Standard-A", "MP3"};
+    }
+};
+
+TEST_F(TestAudioCache, IsKeyNormalized)
+{
+    EXPECT_EQ(getcachekey({"  hello \t  world ", "voice", "MP3"}),
+              getcachekey({"hello world", "voice", "MP3"}));
+    EXPECT_NE(getcachekey({"hello", "voice", "MP3"}),
+              getcachekey({"hello", "voice", "LINEAR16"}));
+    EXPECT_NE(getcachekey({"hello", "voice", "MP3"}),
+              getcachekey({"hello", "other", "MP3"}));
+}
+
+TEST_F(TestAudioCache, IsStoredAudioReturned)
+{
+    AudioCache cache{100};
+    EXPECT_EQ(cache.get(getkey("hello")), nullptr);
+    auto audio = cache.put(getkey("hello"), "audio");
+    ASSERT_NE(audio, nullptr);
+    EXPECT_EQ(cache.get(getkey(" hello ")), audio);
+
+    auto stats = cache.getstats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(stats.bytes, 5);
+}
+
+TEST_F(TestAudioCache, IsLeastRecentlyUsedEvicted)
+{
+    AudioCache cache{10};
+    cache.put(getkey("first"), "aaaa");
+    cache.put(getkey("second"), "bbbb");
+    // first becomes most recent, so second goes when space is needed
+    EXPECT_NE(cache.get(getkey("first")), nullptr);
+    cache.put(getkey("third"), "cccc");
+    EXPECT_NE(cache.get(getkey("first")), nullptr);
+    EXPECT_EQ(cache.get(getkey("second")), nullptr);
+    EXPECT_NE(cache.get(getkey("third")), nullptr);
+
+    auto stats = cache.getstats();
+    EXPECT_EQ(stats.evictions, 1);
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_EQ(stats.bytes, 8);
+}
+
+TEST_F(TestAudioCache, IsOversizedAudioNotStored)
+{
+    AudioCache cache{4};
+    auto audio = cache.put(getkey("hello"), "too long");
+    ASSERT_NE(audio, nullptr);
+    EXPECT_EQ(*audio, "too long");
+    EXPECT_EQ(cache.get(getkey("hello")), nullptr);
+    EXPECT_EQ(cache.getstats().entries, 0);
+}
+
+TEST_F(TestAudioCache, IsReplacedEntryAccounted)
+{
+    AudioCache cache{100};
+    cache.put(getkey("hello"), "short");
+    cache.put(getkey("hello"), "much longer");
+    EXPECT_EQ(*cache.get(getkey("hello")), "much longer");
+    auto stats = cache.getstats();
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(stats.bytes, 11);
+}
+
+TEST_F(TestAudioCache, IsCacheSharedByConcurrentSyntheses)
+{
+    static constexpr size_t threads{8}, calls{2000};
+    AudioCache cache{64};
+    std::vector<std::thread> workers;
+    for (size_t worker{}; worker < threads; worker++)
+        workers.emplace_back([&cache, worker]() {
+            for (size_t call{}; call < calls; call++)
+            {
+                // audio of each text is the text itself, so torn entry is
+                // seen as mismatch
+                auto text = std::to_string((worker + call) % 20);
+                if (auto audio = cache.get(getkey(text)))
+                    EXPECT_EQ(*audio, text);
+                else
+                    EXPECT_EQ(*cache.put(getkey(text), std::string{text}),
+                              text);
+            }
+        });
+    for (auto& worker : workers)
+        worker.join();
+
+    auto stats = cache.getstats();
+    EXPECT_EQ(stats.hits + stats.misses, threads * calls);
+    EXPECT_LE(stats.bytes, 64);
+}
@@ -0,0 +1,105 @@
+#include "speech/base64.hpp"
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <string>
+
+using namespace speech::helpers;
+
+class TestBase64 : public testing::Test
+{
+  public:
+    static std::string encode(const std::string& data)
+    {
+        static const std::string alphabet{"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                          "abcdefghijklmnopqrstuvwxyz"
+                                          "0123456789+/"};
+        std::string encoded;
+        uint32_t accumulator{};
+        size_t bits{};
+        for (auto sign : data)
+        {
+            accumulator = (accumulator << 8) | (uint8_t)sign;
+            for (bits += 8; bits >= 6; bits -= 6)
+                encoded.push_back(alphabet[(accumulator >> (bits - 6)) & 63]);
+        }
+        if (bits)
+            encoded.push_back(alphabet[(accumulator << (6 - bits)) & 63]);
+        while (encoded.size() % 4)
+            encoded.push_back('=');
+        return encoded;
+    }
+
+    std::string getrandom(size_t size)
+    {
+        std::string data(size, '\0');
+        for (auto& sign : data)
+            sign = (char)distribution(generator);
+        return data;
+    }
+
+    std::mt19937 generator{5};
+    std::uniform_int_distribution<int> distribution{0, 255};
+};
+
+TEST_F(TestBase64, IsDecodedSizeCorrect)
+{
+    EXPECT_EQ(base64::getdecodedsize(""), 0);
+    EXPECT_EQ(base64::getdecodedsize("TQ=="), 1);
+    EXPECT_EQ(base64::getdecodedsize("TWE="), 2);
+    EXPECT_EQ(base64::getdecodedsize("TWFu"), 3);
+    EXPECT_EQ(base64::getdecodedsize("TWFuTQ"), 4);
+}
+
+TEST_F(TestBase64, IsVectorizedDecodeSameAsScalar)
+{
+    // sizes cover tails shorter and longer than vector block
+    for (size_t size{}; size < 300; size++)
+    {
+        auto data = getrandom(size);
+        auto encoded = encode(data);
+        std::string decoded(base64::getdecodedsize(encoded), '\0');
+        std::string scalar(decoded.size(), '\0');
+        ASSERT_TRUE(base64::decode(encoded, decoded));
+        ASSERT_TRUE(base64::decodescalar(encoded, scalar));
+        EXPECT_EQ(decoded, data);
+        EXPECT_EQ(scalar, data);
+    }
+}
+
+TEST_F(TestBase64, IsMalformedInputRejected)
+{
+    auto encoded = encode(getrandom(96));
+    std::string decoded(base64::getdecodedsize(encoded), '\0');
+    // invalid sign placed both in vector block and in scalar tail
+    for (auto pos : {size_t{5}, encoded.size() - 3})
+    {
+        auto corrupted = encoded;
+        corrupted[pos] = '*';
+        EXPECT_FALSE(base64::decode(corrupted, decoded));
+        EXPECT_FALSE(base64::decodescalar(corrupted, decoded));
+    }
+    std::string small(decoded.size() - 1, '\0');
+    EXPECT_FALSE(base64::decode(encoded, small));
+    // single sign left over cannot make up byte
+    std::string truncated(base64::getdecodedsize("TWFuT"), '\0');
+    EXPECT_FALSE(base64::decode("TWFuT", truncated));
+}
+
+TEST_F(TestBase64, IsStreamDecodedInPiecesSameAsWhole)
+{
+    auto data = getrandom(1000);
+    auto encoded = encode(data);
+    std::uniform_int_distribution<size_t> pieces{0, 70};
+    base64::StreamDecoder decoder;
+    std::string decoded;
+    for (size_t pos{}; pos < encoded.size();)
+    {
+        auto size = std::min(pieces(generator), encoded.size() - pos);
+        ASSERT_TRUE(decoder.decode(encoded.substr(pos, size), decoded));
+        pos += size;
+    }
+    ASSERT_TRUE(decoder.finish(decoded));
+    EXPECT_EQ(decoded, data);
+}
@@ -0,0 +1,118 @@
+#include "fake_textfromvoice.hpp"
+#include "speech/stt/batch.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TestAudioDuration : public testing::Test
+{
+  public:
+    // stream info block with given rate and total samples, 16 bit mono
+    static std::string getflac(uint64_t rate, uint64_t samples)
+    {
+        std::string audio{"fLaC"};
+        audio += std::string{"\x80\x00\x00\x22", 4};
+        audio += std::string(10, '\0');
+        uint64_t bits = rate << 44 | 15ull << 36 | samples;
+        for (int shift{56}; shift >= 0; shift -= 8)
+            audio.push_back((char)(bits >> shift));
+        audio += std::string(16, '\0');
+        return audio;
+    }
+
+    // extra chunk before data checks that chunks are walked, not assumed
+    static std::string getwav(uint32_t bytespersec, uint32_t datasize)
+    {
+        std::string audio{"RIFF"};
+        append(audio, 0);
+        audio += "WAVEfmt ";
+        append(audio, 16);
+        append(audio, 0x00010001);
+        append(audio, bytespersec / 2);
+        append(audio, bytespersec);
+        append(audio, 0x00100002);
+        audio += "LIST";
+        append(audio, 3);
+        audio += std::string(4, '\0');
+        audio += "data";
+        append(audio, datasize);
+        audio += std::string(datasize, '\0');
+        return audio;
+    }
+
+    static void append(std::string& audio, uint32_t value)
+    {
+        char bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        audio.append(bytes, sizeof(bytes));
+    }
+
+    static double getduration(const std::string& audio, stt::format type)
+    {
+        return stt::getaudioduration(std::as_bytes(std::span{audio}), type);
+    }
+};
+
+TEST_F(TestAudioDuration, IsFlacDurationTakenFromStreamInfo)
+{
+    EXPECT_DOUBLE_EQ(getduration(getflac(16000, 32000), stt::format::flac),
+                     2.0);
+    EXPECT_DOUBLE_EQ(getduration(getflac(44100, 22050), stt::format::flac),
+                     0.5);
+    EXPECT_DOUBLE_EQ(getduration(getflac(0, 22050), stt::format::flac), 0);
+    EXPECT_DOUBLE_EQ(getduration("fLaC", stt::format::flac), 0);
+}
+
+TEST_F(TestAudioDuration, IsWavDurationTakenFromHeader)
+{
+    EXPECT_DOUBLE_EQ(getduration(getwav(32000, 16000), stt::format::linear16),
+                     0.5);
+    // truncated data chunk counts only bytes present
+    auto audio = getwav(32000, 16000);
+    audio.resize(audio.size() - 8000);
+    EXPECT_DOUBLE_EQ(getduration(audio, stt::format::linear16), 0.25);
+}
+
+TEST_F(TestAudioDuration, IsRawDurationTakenFromSize)
+{
+    EXPECT_DOUBLE_EQ(
+        getduration(std::string(32000, '\0'), stt::format::linear16), 1.0);
+    EXPECT_DOUBLE_EQ(getduration("", stt::format::linear16), 0);
+}
+
+class TestBatchTranscriber : public testing::Test
+{};
+
+TEST_F(TestBatchTranscriber, AreInputsTranscribedInOrderAndBounded)
+{
+    auto stt = std::make_shared<FakeTextFromVoice>();
+    stt::BatchTranscriber batch{stt, 3};
+    std::vector<stt::batchinput_t> inputs;
+    for (size_t size{1}; size <= 20; size++)
+        inputs.push_back({{},
+                          std::vector<std::byte>(size * 2),
+                          stt::format::linear16,
+                          stt::language::english});
+    // same transcriber runs again on workers it kept
+    for (auto run{0}; run < 2; run++)
+    {
+        auto results = batch.run(inputs);
+        ASSERT_EQ(results.size(), inputs.size());
+        for (size_t index{}; index < results.size(); index++)
+        {
+            ASSERT_TRUE(results[index].transcript);
+            EXPECT_EQ(results[index].transcript->first,
+                      std::to_string(inputs[index].audio.size()));
+            EXPECT_TRUE(results[index].error.empty());
+        }
+        auto stats = batch.getstats();
+        EXPECT_EQ(stats.inputs, inputs.size());
+        EXPECT_EQ(stats.failed, 0);
+    }
+    EXPECT_LE(stt->peak, 3);
+    EXPECT_GT(stt->peak, 1);
+}
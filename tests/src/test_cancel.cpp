@@ -0,0 +1,111 @@
+#include "speech/cancel.hpp"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace speech::helpers;
+using namespace std::chrono_literals;
+
+class TestCancelToken : public testing::Test
+{};
+
+TEST_F(TestCancelToken, IsTokenCancelledOnce)
+{
+    CancelToken token;
+    EXPECT_FALSE(token.iscancelled());
+    EXPECT_FALSE(token.getdeadline());
+    EXPECT_TRUE(token.cancel());
+    EXPECT_TRUE(token.iscancelled());
+    EXPECT_FALSE(token.cancel());
+}
+
+TEST_F(TestCancelToken, IsTokenExpiredByDeadline)
+{
+    CancelToken expired{std::chrono::steady_clock::now() - 1ms};
+    EXPECT_TRUE(expired.iscancelled());
+    CancelToken pending{std::chrono::steady_clock::now() + 1h};
+    EXPECT_FALSE(pending.iscancelled());
+}
+
+TEST_F(TestCancelToken, AreCallbacksRunOnCancel)
+{
+    CancelToken token;
+    int called{}, unsubscribed{};
+    token.subscribe([&called]() { called++; });
+    auto id = token.subscribe([&unsubscribed]() { unsubscribed++; });
+    token.unsubscribe(id);
+    token.cancel();
+    token.cancel();
+    EXPECT_EQ(called, 1);
+    EXPECT_EQ(unsubscribed, 0);
+    // late subscriber is called at once
+    token.subscribe([&called]() { called++; });
+    EXPECT_EQ(called, 2);
+}
+
+TEST_F(TestCancelToken, IsCallbackBoundToItsLifetime)
+{
+    auto token = std::make_shared<CancelToken>();
+    int called{};
+    {
+        CancelCallback callback{token, [&called]() { called++; }};
+    }
+    token->cancel();
+    EXPECT_EQ(called, 0);
+    CancelCallback none{nullptr, [&called]() { called++; }};
+    EXPECT_EQ(called, 0);
+}
+
+TEST_F(TestCancelToken, IsWaitForResultInterrupted)
+{
+    CancelToken token;
+    std::promise<int> promise;
+    auto result = promise.get_future();
+    auto canceller = std::async(std::launch::async, [&token]() {
+        std::this_thread::sleep_for(20ms);
+        token.cancel();
+    });
+    EXPECT_FALSE(token.wait(result));
+    canceller.get();
+
+    CancelToken other;
+    promise.set_value(1);
+    EXPECT_TRUE(other.wait(result));
+}
+
+TEST_F(TestCancelToken, AreInstanceTokensCancelledTogether)
+{
+    Canceller canceller;
+    auto first = canceller.gettoken();
+    auto second = canceller.gettoken(1h);
+    EXPECT_FALSE(first->getdeadline());
+    EXPECT_TRUE(second->getdeadline());
+    EXPECT_TRUE(canceller.cancel());
+    EXPECT_TRUE(first->iscancelled());
+    EXPECT_TRUE(second->iscancelled());
+    // calls started afterwards are not affected
+    auto later = canceller.gettoken();
+    EXPECT_FALSE(later->iscancelled());
+}
+
+TEST_F(TestCancelToken, IsNestedCallCancelledWithOuter)
+{
+    Canceller outer, inner;
+    auto parent = outer.gettoken(1min);
+    std::shared_ptr<CancelToken> child;
+    {
+        CancelScope scope{parent};
+        EXPECT_EQ(CancelScope::gettoken(), parent);
+        // inner call is bound by outer deadline
+        child = inner.gettoken(1h);
+        EXPECT_EQ(child->getdeadline(), parent->getdeadline());
+    }
+    EXPECT_EQ(CancelScope::gettoken(), nullptr);
+    EXPECT_FALSE(inner.gettoken()->iscancelled());
+    outer.cancel();
+    EXPECT_TRUE(child->iscancelled());
+}
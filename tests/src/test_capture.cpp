@@ -0,0 +1,86 @@
+#include "speech/stt/capture.hpp"
+
+#include "gtest/gtest.h"
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace stt::capture;
+
+class TestRingBuffer : public testing::Test
+{
+  public:
+    static std::vector<int16_t> getsequence(size_t size, int16_t first = 0)
+    {
+        std::vector<int16_t> samples(size);
+        std::iota(samples.begin(), samples.end(), first);
+        return samples;
+    }
+};
+
+TEST_F(TestRingBuffer, IsCapacityRoundedToPowerOfTwo)
+{
+    EXPECT_EQ(RingBuffer(100).capacity(), 128);
+    EXPECT_EQ(RingBuffer(128).capacity(), 128);
+    EXPECT_EQ(RingBuffer(0).capacity(), 2);
+}
+
+TEST_F(TestRingBuffer, IsWriteLimitedToFreeSpace)
+{
+    RingBuffer ring{8};
+    auto samples = getsequence(12);
+    EXPECT_EQ(ring.write(samples), 8);
+    EXPECT_EQ(ring.available(), 8);
+    EXPECT_EQ(ring.write(samples), 0);
+
+    std::vector<int16_t> output(12);
+    EXPECT_EQ(ring.read(output), 8);
+    EXPECT_EQ(ring.available(), 0);
+    EXPECT_EQ(ring.read(output), 0);
+    output.resize(8);
+    EXPECT_EQ(output, getsequence(8));
+}
+
+TEST_F(TestRingBuffer, IsDataKeptAcrossWrapAround)
+{
+    RingBuffer ring{8};
+    std::vector<int16_t> output(5);
+    for (int16_t round{}; round < 10; round++)
+    {
+        auto samples = getsequence(5, (int16_t)(round * 5));
+        ASSERT_EQ(ring.write(samples), 5);
+        ASSERT_EQ(ring.read(output), 5);
+        EXPECT_EQ(output, samples);
+    }
+}
+
+TEST_F(TestRingBuffer, IsSequenceTransferredBetweenThreads)
+{
+    static constexpr size_t total{20000};
+    RingBuffer ring{64};
+    auto samples = getsequence(total);
+    std::thread producer([&ring, &samples]() {
+        std::span<const int16_t> pending{samples};
+        while (!pending.empty())
+        {
+            auto size = ring.write(
+                pending.first(std::min<size_t>(pending.size(), 24)));
+            pending = pending.subspan(size);
+            if (size == 0)
+                std::this_thread::yield();
+        }
+    });
+    std::vector<int16_t> received;
+    std::vector<int16_t> chunk(40);
+    while (received.size() < total)
+    {
+        auto size = ring.read(chunk);
+        if (size == 0)
+            std::this_thread::yield();
+        received.insert(received.end(), chunk.begin(),
+                        chunk.begin() + (std::ptrdiff_t)size);
+    }
+    producer.join();
+    EXPECT_EQ(received, samples);
+}
@@ -0,0 +1,87 @@
+#include "speech/tts/diskcache.hpp"
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace tts;
+
+class TestDiskCache : public testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() /
+                    ("speech-ut-" + std::to_string(getpid()));
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    static std::string readfile(const std::filesystem::path& path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(ifs), {}};
+    }
+
+    std::filesystem::path directory;
+};
+
+TEST_F(TestDiskCache, IsStoredAudioReturned)
+{
+    DiskCache cache{directory, 1000};
+    audiokey_t key{"hello", "voice", "MP3"};
+    EXPECT_FALSE(cache.get(key));
+    auto path = cache.put(key, "audio");
+    ASSERT_TRUE(path);
+    EXPECT_EQ(path->extension(), ".mp3");
+    EXPECT_EQ(cache.get({" hello", "voice", "MP3"}), path);
+    EXPECT_EQ(readfile(*path), "audio");
+
+    auto stats = cache.getstats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(stats.bytes, 5);
+}
+
+TEST_F(TestDiskCache, IsFileMovedIntoCache)
+{
+    DiskCache cache{directory, 1000};
+    auto file = directory / "download.tmp";
+    std::ofstream(file, std::ios::binary) << "downloaded";
+    auto path = cache.putfile({"hello", "voice", "LINEAR16"}, file);
+    ASSERT_TRUE(path);
+    EXPECT_EQ(path->extension(), ".wav");
+    EXPECT_FALSE(std::filesystem::exists(file));
+    EXPECT_EQ(readfile(*path), "downloaded");
+    EXPECT_FALSE(cache.putfile({"other", "voice", "MP3"}, file));
+}
+
+TEST_F(TestDiskCache, IsOldestFileEvictedOverBudget)
+{
+    using namespace std::chrono_literals;
+    DiskCache cache{directory, 10};
+    auto first = cache.put({"first", "voice", "MP3"}, "aaaaaa");
+    ASSERT_TRUE(first);
+    // access time is kept in modification time
+    std::filesystem::last_write_time(
+        *first, std::filesystem::file_time_type::clock::now() - 1h);
+    ASSERT_TRUE(cache.put({"second", "voice", "MP3"}, "bbbbbb"));
+    // eviction runs in background once budget is exceeded
+    for (auto waited{0ms}; waited < 5s && cache.getstats().evictions == 0;
+         waited += 10ms)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(cache.getstats().evictions, 1);
+    EXPECT_FALSE(cache.get({"first", "voice", "MP3"}));
+    EXPECT_TRUE(cache.get({"second", "voice", "MP3"}));
+}
@@ -0,0 +1,39 @@
+#include "speech/helpers.hpp"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace speech::helpers;
+
+class TestSplitSentences : public testing::Test
+{
+  public:
+    using sentences_t = std::vector<std::string>;
+};
+
+TEST_F(TestSplitSentences, IsTextSplitAtTerminals)
+{
+    EXPECT_EQ(splitsentences("Hello world. How are you? Fine! Bye; now"),
+              (sentences_t{"Hello world.", "How are you?", "Fine!", "Bye;",
+                           "now"}));
+}
+
+TEST_F(TestSplitSentences, IsTextSplitAtNewLines)
+{
+    EXPECT_EQ(splitsentences("first line\nsecond line\n\n  third  "),
+              (sentences_t{"first line", "second line", "third"}));
+}
+
+TEST_F(TestSplitSentences, IsTerminalInsideWordKept)
+{
+    EXPECT_EQ(splitsentences("Pi is 3.14 today. Visit example.com now."),
+              (sentences_t{"Pi is 3.14 today.", "Visit example.com now."}));
+}
+
+TEST_F(TestSplitSentences, IsBlankTextLeftEmpty)
+{
+    EXPECT_TRUE(splitsentences("").empty());
+    EXPECT_TRUE(splitsentences(" \t\n\r\n").empty());
+}
@@ -0,0 +1,135 @@
+#include "fake_textfromvoice.hpp"
+#include "speech/stt/session.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace stt;
+using namespace std::chrono_literals;
+
+// silence of given size, read as file would be or as microphone would
+class FakeSource : public capture::SourceIf
+{
+  public:
+    FakeSource(size_t size, bool realtime) : size{size}, realtime{realtime}
+    {}
+
+    bool open() override
+    {
+        position = 0;
+        return true;
+    }
+
+    size_t read(std::span<int16_t> samples) override
+    {
+        if (realtime)
+            std::this_thread::sleep_for(1ms);
+        auto count = std::min(samples.size(), size - position);
+        std::fill_n(samples.begin(), count, int16_t{});
+        position += realtime ? 0 : count;
+        return count;
+    }
+
+    void close() override
+    {}
+
+    bool isrealtime() const override
+    {
+        return realtime;
+    }
+
+  private:
+    const size_t size;
+    const bool realtime;
+    size_t position{};
+};
+
+class TestListenSession : public testing::Test
+{
+  public:
+    // whole source is cut into utterances of 100 ms
+    sessionconfig_t getconfig(size_t samples, bool realtime) const
+    {
+        sessionconfig_t config;
+        config.source = std::make_shared<FakeSource>(samples, realtime);
+        config.vad = std::nullopt;
+        config.maxutterance = 100ms;
+        config.queuesize = 2;
+        config.concurrency = 3;
+        return config;
+    }
+
+    void collect(const sessionresult_t& result)
+    {
+        std::lock_guard lock(mtx);
+        results.push_back(result);
+    }
+
+    const std::shared_ptr<FakeTextFromVoice> stt{
+        std::make_shared<FakeTextFromVoice>()};
+    std::mutex mtx;
+    std::vector<sessionresult_t> results;
+};
+
+TEST_F(TestListenSession, AreAllUtterancesDeliveredOnceSourceIsExhausted)
+{
+    // last utterance is cut short by end of audio
+    ListenSession session{stt, getconfig(20 * 1600 + 320, false),
+                          [this](const auto& result) { collect(result); }};
+    ASSERT_TRUE(session.start());
+    EXPECT_TRUE(session.wait());
+    session.stop();
+
+    ASSERT_EQ(results.size(), 21);
+    for (size_t index{}; index < results.size(); index++)
+    {
+        EXPECT_EQ(results[index].utterance, index);
+        ASSERT_TRUE(results[index].transcript);
+        EXPECT_EQ(results[index].transcript->first,
+                  index < 20 ? "3200" : "640");
+    }
+    auto stats = session.getstats();
+    EXPECT_EQ(stats.utterances, 21);
+    EXPECT_EQ(stats.transcripts, 21);
+    EXPECT_EQ(stats.dropped, 0);
+    EXPECT_EQ(stats.delivery.depth, 0);
+}
+
+TEST_F(TestListenSession, IsWaitEndedByStopForRealtimeSource)
+{
+    ListenSession session{stt, getconfig(320, true),
+                          [this](const auto& result) { collect(result); }};
+    ASSERT_TRUE(session.start());
+    auto waiting =
+        std::async(std::launch::async, [&session]() { return session.wait(); });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(waiting.wait_for(0ms), std::future_status::timeout);
+    session.stop();
+    EXPECT_FALSE(waiting.get());
+    EXPECT_FALSE(session.wait());
+}
+
+TEST_F(TestListenSession, IsDeliveryContinuedWhenCallbackThrows)
+{
+    ListenSession session{stt, getconfig(6 * 1600, false),
+                          [this](const auto& result) {
+                              collect(result);
+                              if (result.utterance % 2 == 0)
+                                  throw std::runtime_error("callback failed");
+                          }};
+    ASSERT_TRUE(session.start());
+    EXPECT_TRUE(session.wait());
+    session.stop();
+
+    ASSERT_EQ(results.size(), 6);
+    for (size_t index{}; index < results.size(); index++)
+        EXPECT_EQ(results[index].utterance, index);
+    EXPECT_EQ(session.getstats().callbackfailures, 3);
+}
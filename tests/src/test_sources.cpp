@@ -0,0 +1,102 @@
+#include "speech/stt/sources.hpp"
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <string>
+#include <vector>
+
+using namespace stt::capture;
+
+class TestFileSource : public testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        path = std::filesystem::temp_directory_path() /
+               ("speech-ut-" + std::to_string(getpid()) + ".wav");
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(path);
+    }
+
+    // one second of mono tone of given frequency and amplitude
+    void writewav(uint32_t rate, double frequency, double amplitude)
+    {
+        std::vector<int16_t> samples(rate);
+        for (size_t index{}; index < samples.size(); index++)
+            samples[index] = (int16_t)std::lround(
+                amplitude * std::sin(2 * std::numbers::pi * frequency *
+                                     (double)index / rate));
+        const auto size = (uint32_t)(samples.size() * sizeof(int16_t));
+        std::string audio{"RIFF"};
+        append(audio, 36 + size);
+        audio += "WAVEfmt ";
+        append(audio, 16);
+        append(audio, 0x00010001);
+        append(audio, rate);
+        append(audio, rate * 2);
+        append(audio, 0x00100002);
+        audio += "data";
+        append(audio, size);
+        audio.append((const char*)samples.data(), size);
+        std::ofstream(path, std::ios::binary) << audio;
+    }
+
+    static void append(std::string& audio, uint32_t value)
+    {
+        char bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        audio.append(bytes, sizeof(bytes));
+    }
+
+    // rms of source audio, edges where filter runs out of input are skipped
+    double getrms()
+    {
+        FileSource source{path};
+        EXPECT_TRUE(source.open());
+        std::vector<int16_t> samples(2 * sampleRate);
+        samples.resize(source.read(samples));
+        EXPECT_EQ(samples.size(), sampleRate);
+        double sum{};
+        const size_t edge{sampleRate / 10};
+        for (size_t index{edge}; index + edge < samples.size(); index++)
+            sum += (double)samples[index] * samples[index];
+        return std::sqrt(sum / (double)(samples.size() - 2 * edge));
+    }
+
+    std::filesystem::path path;
+};
+
+TEST_F(TestFileSource, IsToneBelowNyquistKeptWhenDownsampling)
+{
+    for (auto rate : {44100u, 48000u})
+    {
+        writewav(rate, 1000, 10000);
+        EXPECT_NEAR(getrms(), 10000 / std::numbers::sqrt2, 100) << rate;
+    }
+}
+
+TEST_F(TestFileSource, IsToneAboveNyquistFilteredWhenDownsampling)
+{
+    // would alias to 4 kHz at full level without low-pass filter
+    for (auto rate : {44100u, 48000u})
+    {
+        writewav(rate, 12000, 10000);
+        EXPECT_LT(getrms(), 10000 / std::numbers::sqrt2 / 100) << rate;
+    }
+}
+
+TEST_F(TestFileSource, IsToneKeptWhenUpsampling)
+{
+    writewav(8000, 1000, 10000);
+    EXPECT_NEAR(getrms(), 10000 / std::numbers::sqrt2, 100);
+}
@@ -0,0 +1,134 @@
+#include "speech/tts/speakqueue.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace tts;
+using namespace std::chrono_literals;
+
+class TestSpeakQueue : public testing::Test
+{
+  public:
+    // first utterance holds worker until released, so others stay queued
+    speakhandle_t pushblocking(SpeakQueue& queue)
+    {
+        auto handle = queue.push([this]() {
+            started.set_value();
+            release.wait();
+            return spoken_t{true, std::nullopt, 1};
+        });
+        started.get_future().wait();
+        return handle;
+    }
+
+    static SpeakQueue::job_t getjob(std::vector<int>& order, int id)
+    {
+        return [&order, id]() {
+            order.push_back(id);
+            return spoken_t{true, std::nullopt, 1};
+        };
+    }
+
+    std::promise<void> started;
+    std::promise<void> released;
+    std::shared_future<void> release{released.get_future().share()};
+};
+
+TEST_F(TestSpeakQueue, AreUtterancesSpokenInOrder)
+{
+    SpeakQueue queue{4, queuepolicy::block};
+    std::vector<int> order;
+    std::vector<speakhandle_t> handles;
+    for (int id{}; id < 4; id++)
+        handles.push_back(queue.push(getjob(order, id)));
+    queue.wait();
+    EXPECT_FALSE(queue.wait());
+    EXPECT_EQ(order, (std::vector{0, 1, 2, 3}));
+    for (auto& handle : handles)
+        EXPECT_TRUE(handle.get());
+    EXPECT_EQ(queue.getstats().spoken, 4);
+    EXPECT_EQ(queue.pending(), 0);
+}
+
+TEST_F(TestSpeakQueue, IsOldestDroppedWhenFull)
+{
+    SpeakQueue queue{2, queuepolicy::dropoldest};
+    std::vector<int> order;
+    auto speaking = pushblocking(queue);
+    auto oldest = queue.push(getjob(order, 1));
+    queue.push(getjob(order, 2));
+    queue.push(getjob(order, 3));
+    EXPECT_FALSE(oldest.get());
+    released.set_value();
+    queue.wait();
+    EXPECT_TRUE(speaking.get());
+    EXPECT_EQ(order, (std::vector{2, 3}));
+    EXPECT_EQ(queue.getstats().dropped, 1);
+}
+
+TEST_F(TestSpeakQueue, IsNewestRejectedWhenFull)
+{
+    SpeakQueue queue{2, queuepolicy::reject};
+    std::vector<int> order;
+    pushblocking(queue);
+    queue.push(getjob(order, 1));
+    queue.push(getjob(order, 2));
+    auto rejected = queue.push(getjob(order, 3));
+    EXPECT_FALSE(rejected.get());
+    released.set_value();
+    queue.wait();
+    EXPECT_EQ(order, (std::vector{1, 2}));
+    EXPECT_EQ(queue.getstats().rejected, 1);
+}
+
+TEST_F(TestSpeakQueue, IsPushBlockedWhenFull)
+{
+    SpeakQueue queue{1, queuepolicy::block};
+    std::vector<int> order;
+    pushblocking(queue);
+    queue.push(getjob(order, 1));
+    std::atomic<bool> pushed{false};
+    auto pusher = std::async(std::launch::async, [&]() {
+        queue.push(getjob(order, 2));
+        pushed = true;
+    });
+    EXPECT_EQ(pusher.wait_for(50ms), std::future_status::timeout);
+    EXPECT_FALSE(pushed);
+    released.set_value();
+    pusher.get();
+    queue.wait();
+    EXPECT_EQ(order, (std::vector{1, 2}));
+}
+
+TEST_F(TestSpeakQueue, AreQueuedUtterancesCancelled)
+{
+    SpeakQueue queue{4, queuepolicy::block};
+    std::vector<int> order;
+    auto speaking = pushblocking(queue);
+    auto queued = queue.push(getjob(order, 1));
+    EXPECT_EQ(queue.pending(), 2);
+    EXPECT_TRUE(queue.cancel());
+    EXPECT_FALSE(queued.get());
+    EXPECT_EQ(queue.pending(), 1);
+    released.set_value();
+    EXPECT_TRUE(speaking.get());
+    queue.wait();
+    EXPECT_TRUE(order.empty());
+    EXPECT_EQ(queue.getstats().cancelled, 1);
+    EXPECT_FALSE(queue.cancel());
+}
+
+TEST_F(TestSpeakQueue, IsFailedUtteranceReported)
+{
+    SpeakQueue queue{1, queuepolicy::block};
+    auto handle = queue.push(
+        []() -> spoken_t { throw std::runtime_error("playback failed"); });
+    EXPECT_THROW(handle.get(), std::runtime_error);
+    queue.wait();
+    EXPECT_EQ(queue.getstats().spoken, 1);
+}
@@ -0,0 +1,33 @@
+#include "fake_textfromvoice.hpp"
+#include "speech/threadpool.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace stt;
+
+class TestTranscribeAsync : public testing::Test
+{};
+
+TEST_F(TestTranscribeAsync, AreRecognitionsBoundedOnSharedPool)
+{
+    FakeTextFromVoice stt;
+    std::vector<std::future<std::optional<transcript_t>>> results;
+    for (size_t size{}; size < 64; size++)
+        results.push_back(stt.transcribeasync(std::vector<std::byte>(size),
+                                              format::linear16,
+                                              language::english));
+    for (size_t size{}; size < results.size(); size++)
+    {
+        auto transcript = results[size].get();
+        ASSERT_TRUE(transcript);
+        EXPECT_EQ(transcript->first, std::to_string(size));
+    }
+    // half of workers at most on pool, one more run by caller when full
+    const auto workers =
+        speech::helpers::ThreadPool::getdefault()->getworkers();
+    EXPECT_LE(stt.peak, std::max<size_t>(1, workers / 2) + 1);
+    EXPECT_GT(stt.peak, 1);
+}
@@ -0,0 +1,112 @@
+#include "speech/cancel.hpp"
+#include "speech/threadpool.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace speech::helpers;
+using namespace std::chrono_literals;
+
+class TestTaskGroup : public testing::Test
+{
+  public:
+    // task holding its slot until released, so group stays full
+    void submitblocking(TaskGroup& group)
+    {
+        ASSERT_TRUE(group.submit([this]() {
+            started.set_value();
+            release.wait();
+        }));
+        started.get_future().wait();
+    }
+
+    const std::shared_ptr<ThreadPool> pool{std::make_shared<ThreadPool>(2)};
+    std::promise<void> started;
+    std::promise<void> released;
+    std::shared_future<void> release{released.get_future().share()};
+};
+
+TEST_F(TestTaskGroup, AreResultsReturned)
+{
+    TaskGroup group{pool, 4};
+    std::vector<std::future<int>> results;
+    for (int value{}; value < 20; value++)
+        results.push_back(group.async([value]() { return value * value; }));
+    for (int value{}; value < 20; value++)
+        EXPECT_EQ(results[value].get(), value * value);
+    group.wait();
+    EXPECT_EQ(group.getpending(), 0);
+    EXPECT_FALSE(group.wait());
+}
+
+TEST_F(TestTaskGroup, IsTaskRunInlineWhenFull)
+{
+    TaskGroup group{pool, 1};
+    submitblocking(group);
+    EXPECT_FALSE(group.submit([]() {}));
+    auto result = group.async([]() { return std::this_thread::get_id(); });
+    EXPECT_EQ(result.get(), std::this_thread::get_id());
+    EXPECT_EQ(pool->getstats().inlined, 1);
+    released.set_value();
+}
+
+TEST_F(TestTaskGroup, AreQueuedTasksCancelled)
+{
+    auto single = std::make_shared<ThreadPool>(1);
+    TaskGroup group{single, 4};
+    TaskGroup other{single, 4};
+    std::promise<void> ready;
+    std::atomic<bool> ran{false};
+    ASSERT_TRUE(other.submit([this, &ready]() {
+        ready.set_value();
+        release.wait();
+    }));
+    ready.get_future().wait();
+    // only worker is busy with other group, so task stays queued
+    auto result = group.async([&ran]() { ran = true; });
+    EXPECT_EQ(group.getpending(), 1);
+    EXPECT_TRUE(group.cancel());
+    EXPECT_EQ(group.getpending(), 0);
+    EXPECT_FALSE(group.cancel());
+    released.set_value();
+    other.wait();
+    EXPECT_THROW(result.get(), std::future_error);
+    EXPECT_FALSE(ran);
+    EXPECT_EQ(single->getstats().cancelled, 1);
+}
+
+TEST_F(TestTaskGroup, IsCancellableTaskDroppedWhileWaitingForSlot)
+{
+    TaskGroup group{pool, 1};
+    submitblocking(group);
+    CancelToken token;
+    auto canceller = std::async(std::launch::async, [&token]() {
+        std::this_thread::sleep_for(20ms);
+        token.cancel();
+    });
+    // caller waits for slot instead of running task itself
+    auto result = group.async([]() { return 1; }, token);
+    canceller.get();
+    EXPECT_THROW(result.get(), std::future_error);
+    EXPECT_EQ(pool->getstats().inlined, 0);
+    released.set_value();
+}
+
+TEST_F(TestTaskGroup, IsCancellableTaskRunOnceSlotIsFree)
+{
+    TaskGroup group{pool, 1};
+    submitblocking(group);
+    CancelToken token;
+    auto releaser = std::async(std::launch::async, [this]() {
+        std::this_thread::sleep_for(20ms);
+        released.set_value();
+    });
+    auto result = group.async([]() { return 1; }, token);
+    EXPECT_EQ(result.get(), 1);
+    releaser.get();
+}
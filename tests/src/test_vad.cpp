@@ -0,0 +1,141 @@
+#include "speech/stt/capture.hpp"
+#include "speech/stt/vad.hpp"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+using namespace stt::capture;
+
+class TestVad : public testing::Test
+{
+  public:
+    // quiet wideband noise around -50 dBFS
+    std::vector<int16_t> getnoise(std::chrono::milliseconds duration)
+    {
+        std::vector<int16_t> samples(getsize(duration));
+        for (auto& sample : samples)
+            sample = (int16_t)distribution(generator);
+        return samples;
+    }
+
+    static std::vector<int16_t> gettone(std::chrono::milliseconds duration)
+    {
+        std::vector<int16_t> samples(getsize(duration));
+        for (size_t pos{}; pos < samples.size(); pos++)
+            samples[pos] = (int16_t)(8000 * std::sin(2 * std::numbers::pi *
+                                                     300 * (double)pos /
+                                                     sampleRate));
+        return samples;
+    }
+
+    static size_t getsize(std::chrono::milliseconds duration)
+    {
+        return (size_t)duration.count() * sampleRate / 1000;
+    }
+
+    // audio fed in 20 ms chunks as capture does, events are collected
+    static std::vector<vadevent> feed(Endpointer& endpointer,
+                                      const std::vector<int16_t>& samples,
+                                      std::vector<int16_t>& output)
+    {
+        std::vector<vadevent> events;
+        std::span<const int16_t> pending{samples};
+        while (!pending.empty())
+        {
+            auto size = std::min<size_t>(pending.size(), sampleRate / 50);
+            if (auto event = endpointer.process(pending.first(size), output);
+                event != vadevent::none)
+                events.push_back(event);
+            pending = pending.subspan(size);
+        }
+        return events;
+    }
+
+    static std::vector<int16_t>
+        join(std::initializer_list<std::vector<int16_t>> parts)
+    {
+        std::vector<int16_t> samples;
+        for (const auto& part : parts)
+            samples.insert(samples.end(), part.begin(), part.end());
+        return samples;
+    }
+
+    std::mt19937 generator{5};
+    std::uniform_int_distribution<int> distribution{-100, 100};
+};
+
+TEST_F(TestVad, IsVectorizedEnergySameAsScalar)
+{
+    std::uniform_int_distribution<int> full{-32768, 32767};
+    for (size_t size{}; size < 200; size++)
+    {
+        std::vector<int16_t> samples(size);
+        for (auto& sample : samples)
+            sample = (int16_t)full(generator);
+        EXPECT_EQ(getenergy(samples), getenergyscalar(samples));
+        EXPECT_EQ(getzerocrossings(samples), getzerocrossingsscalar(samples));
+    }
+    // extreme samples must not overflow pairwise sums
+    std::vector<int16_t> extremes(160, -32768);
+    EXPECT_EQ(getenergy(extremes), getenergyscalar(extremes));
+    EXPECT_EQ(getenergy(extremes), 160ull * 32768 * 32768);
+}
+
+TEST_F(TestVad, AreZeroCrossingsCounted)
+{
+    std::vector<int16_t> samples{1, -1, 1, -1, 0, 5, -5};
+    EXPECT_EQ(getzerocrossingsscalar(samples), 5);
+    EXPECT_EQ(getzerocrossings(samples), 5);
+}
+
+TEST_F(TestVad, IsTrailingSilenceOrderedByEndpointing)
+{
+    auto fast = getvadconfig(endpointing::fast);
+    auto balanced = getvadconfig(endpointing::balanced);
+    auto accurate = getvadconfig(endpointing::accurate);
+    EXPECT_LT(fast.trailing, balanced.trailing);
+    EXPECT_LT(balanced.trailing, accurate.trailing);
+}
+
+TEST_F(TestVad, IsUtteranceFoundBetweenNoise)
+{
+    using namespace std::chrono_literals;
+    Endpointer endpointer{getvadconfig(endpointing::balanced)};
+    auto samples = join({getnoise(500ms), gettone(500ms), getnoise(1000ms)});
+    std::vector<int16_t> output;
+    auto events = feed(endpointer, samples, output);
+
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events[0], vadevent::started);
+    EXPECT_EQ(events[1], vadevent::ended);
+    EXPECT_FALSE(endpointer.isspeaking());
+    EXPECT_GT(endpointer.getnoisefloor(), 0);
+    // preroll, whole tone and trailing silence are kept, rest is not
+    EXPECT_GE(output.size(), getsize(800ms));
+    EXPECT_LT(output.size(), samples.size());
+
+    // nothing is taken once utterance ended until reset
+    auto size = output.size();
+    EXPECT_TRUE(feed(endpointer, gettone(200ms), output).empty());
+    EXPECT_EQ(output.size(), size);
+    endpointer.reset();
+    EXPECT_EQ(feed(endpointer, gettone(200ms), output),
+              std::vector{vadevent::started});
+    EXPECT_TRUE(endpointer.isspeaking());
+}
+
+TEST_F(TestVad, IsShortClickIgnored)
+{
+    using namespace std::chrono_literals;
+    Endpointer endpointer{getvadconfig(endpointing::balanced)};
+    auto samples = join({getnoise(500ms), gettone(30ms), getnoise(500ms)});
+    std::vector<int16_t> output;
+    EXPECT_TRUE(feed(endpointer, samples, output).empty());
+    EXPECT_TRUE(output.empty());
+    EXPECT_FALSE(endpointer.isspeaking());
+}